@@ -0,0 +1,106 @@
+import argparse
+import struct
+import sys
+
+# Формат записи см. telemetryrecorder.h
+HEADER = struct.Struct('<8sHHHHddqII16s')
+BLOCK = struct.Struct('<HH')
+TELEMETRY = struct.Struct('<qH40hfII')
+GAP = struct.Struct('<qHH')
+
+MAGIC = b'QPTREC\x00\x00'
+BLOCK_TELEMETRY = 1
+BLOCK_GAP = 2
+
+
+def _format(value: float, fill: str) -> str:
+    if fill == '0':
+        s = f'{value:04.5g}'
+    else:
+        s = f'{value:>4.5g}'
+    return s.replace('.', ',')
+
+
+def ReadRecord(file_name: str):
+    """Читает двоичную запись, возвращает заголовок и генератор блоков (тип, данные).
+    BLOCK_TELEMETRY: (timestamp, counter, current, temperature, reserved, status)
+    BLOCK_GAP: (timestamp, counter, lost) - перед кадром counter потеряно lost кадров"""
+    with open(file_name, 'rb') as f:
+        data = f.read()
+
+    magic, version, header_size, samples, _, timebase, scale, start, hw, fw, app = HEADER.unpack_from(data, 0)
+    if magic != MAGIC:
+        raise ValueError(f'{file_name}: not a QPeltierUI record')
+
+    header = {
+        'version': version,
+        'samples': samples,
+        'timebase': timebase,
+        'scale': scale,
+        'start': start,
+        'hardware': hw,
+        'firmware': fw,
+        'app': app.rstrip(b'\x00').decode('latin-1'),
+    }
+
+    def blocks():
+        pos = header_size
+        while pos + BLOCK.size <= len(data):
+            block_type, size = BLOCK.unpack_from(data, pos)
+            pos += BLOCK.size
+            if pos + size > len(data):
+                break
+            if block_type == BLOCK_TELEMETRY:
+                v = TELEMETRY.unpack_from(data, pos)
+                yield BLOCK_TELEMETRY, (v[0], v[1], v[2:42], v[42], v[43], v[44])
+            elif block_type == BLOCK_GAP:
+                yield BLOCK_GAP, GAP.unpack_from(data, pos)
+            pos += size
+
+    return header, blocks()
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Преобразование двоичной записи QPeltierUI в CSV')
+    parser.add_argument('file', type=str, help='Файл записи .qpr')
+    parser.add_argument('output', type=str, nargs='?', default='', help='CSV файл, по умолчанию рядом с записью')
+    args = parser.parse_args()
+
+    output = args.output if args.output else args.file.rsplit('.', 1)[0] + '.csv'
+    try:
+        header, blocks = ReadRecord(args.file)
+    except (OSError, ValueError, struct.error) as err:
+        print(err)
+        sys.exit(1)
+
+    print(f'Запись {args.file}: версия {header["version"]}, QPeltierUI {header["app"]}, период {header["timebase"]} с')
+    index = 0
+    count = 0
+    lost = 0
+    with open(output, 'w', encoding='latin-1', newline='\n') as f:
+        f.write('Index; Time [s]; Current[A]\n')
+        for block_type, values in blocks:
+            if block_type == BLOCK_GAP:
+                # Строк для потерянных кадров нет, время следующих отсчётов сдвигается на пропуск
+                _, counter, gap = values
+                print(f'Пропуск {gap} кадров перед кадром {counter} (отсчёт {index})')
+                index += gap * header['samples']
+                lost += gap
+                continue
+
+            _, _, current, temperature, _, _ = values
+            for i, c in enumerate(current):
+                time = _format(index * header['timebase'], ' ')
+                value = _format(c * header['scale'], '0')
+                if i == 0:
+                    f.write(f'{index}; {time}; {value}; {_format(temperature, "0")}\n')
+                else:
+                    f.write(f'{index}; {time}; {value}\n')
+                index += 1
+            count += 1
+
+    print(f'{count} кадров, потеряно {lost}, {index} отсчётов -> {output}')
+
+
+if __name__ == '__main__':
+    main()
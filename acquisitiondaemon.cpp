@@ -0,0 +1,170 @@
+#include <cmath>
+#include <QDir>
+#include <QPointer>
+#include "acquisitiondaemon.h"
+
+volatile std::sig_atomic_t AcquisitionDaemon::s_signal = 0;
+
+
+AcquisitionDaemon::AcquisitionDaemon(DeviceManager *devices, Options options, QObject *parent)
+    : m_devices(devices), m_options(std::move(options)), QObject(parent) {
+    logger = spdlog::get("qpeltierd");
+    connect(m_devices, &DeviceManager::opened, this, &AcquisitionDaemon::Opened);
+    connect(m_devices, &DeviceManager::closed, this, &AcquisitionDaemon::Closed);
+    connect(&m_signalTimer, &QTimer::timeout, this, [this]() {
+        if (s_signal != 0) {
+            logger->info("Signal {} received", static_cast<int>(s_signal));
+            stop();
+        }
+    });
+    connect(&m_statusTimer, &QTimer::timeout, this, &AcquisitionDaemon::Status);
+}
+
+/**
+ * @brief Обработчики SIGINT и SIGTERM. Обработчик только запоминает сигнал, остановка - в цикле событий
+ */
+void AcquisitionDaemon::installSignalHandlers() {
+    std::signal(SIGINT, &AcquisitionDaemon::SignalHandler);
+    std::signal(SIGTERM, &AcquisitionDaemon::SignalHandler);
+}
+
+void AcquisitionDaemon::SignalHandler(int signal) {
+    s_signal = signal;
+}
+
+/**
+ * @brief Подключиться к портам и начать сбор
+ * @return false, если портов нет или каталог записей не создаётся
+ */
+bool AcquisitionDaemon::start() {
+    if (m_options.record && !QDir().mkpath(m_options.outputDir)) {
+        logger->error("Cannot create output directory {}", m_options.outputDir.toStdString());
+        return false;
+    }
+
+    m_ports = m_options.ports;
+    if (m_ports.isEmpty()) {
+        for (const auto &p : m_devices->availablePorts()) {
+            m_ports.append(p.second);
+        }
+    }
+    if (m_ports.isEmpty()) {
+        logger->error("No devices found");
+        return false;
+    }
+
+    logger->info("Acquisition from {} devices{}{}", m_ports.size(), m_options.profile ? ", profile" : "",
+                 m_options.record ? ", recording to " + m_options.outputDir.toStdString() : "");
+    for (const auto &portName : std::as_const(m_ports)) {
+        m_devices->open(portName);
+    }
+
+    m_signalTimer.start(SignalPollInterval);
+    if (m_options.statusInterval > 0) {
+        m_statusTimer.start(m_options.statusInterval * 1000);
+    }
+    return true;
+}
+
+/**
+ * @brief Дописать телеметрию, закрыть записи и порты. Испускает finished()
+ */
+void AcquisitionDaemon::stop() {
+    if (m_stopping) {
+        return;
+    }
+
+    m_stopping = true;
+    m_signalTimer.stop();
+    m_statusTimer.stop();
+    for (auto session : m_devices->sessions()) {
+        session->drain();
+        session->stopRecording();
+    }
+    m_devices->closeAll();
+    logger->info("Stopped");
+    emit finished();
+}
+
+/**
+ * @brief Новое подключение: версия контроллера (нужна заголовку записи), затем профиль, затем запись
+ */
+void AcquisitionDaemon::Opened(DeviceSession *session) {
+QPointer<DeviceSession> guard(session);
+    // Версию запросила и сама сессия. Ответ на этот запрос приходит после её ответа, версия к этому моменту известна
+    session->worker()->request(tec::Commands::VersionGet, QByteArray(), [this, guard](SerialPortWorker::CommandError error, const QByteArray &) {
+        if (guard.isNull() || m_stopping) {
+            return;
+        }
+        if (error != SerialPortWorker::CommandError::NoError) {
+            logger->warn("{}: no version reply", guard->portName().toStdString());
+        }
+
+        if (!m_options.profile) {
+            StartRecording(guard);
+            return;
+        }
+
+        // Пакет записи живёт вместе с сессией
+        auto parameters = new DeviceParameters(guard.data());
+        parameters->setWorker(guard->worker());
+        connect(parameters, &DeviceParameters::finished, guard.data(), [this, guard](bool ok, int failed) {
+            if (m_stopping) {
+                return;
+            }
+            if (ok) {
+                logger->info("{}: profile applied", guard->portName().toStdString());
+            } else {
+                logger->error("{}: profile applied with {} failed parameters", guard->portName().toStdString(), failed);
+            }
+            StartRecording(guard);
+        }, Qt::SingleShotConnection);
+        parameters->write(*m_options.profile);
+    }, session);
+}
+
+void AcquisitionDaemon::StartRecording(DeviceSession *session) {
+    if (!m_options.record) {
+        return;
+    }
+
+const auto fileName = QDir(m_options.outputDir).filePath(DeviceSession::recordFileName(session->portName()));
+    if (session->startRecording(fileName)) {
+        logger->info("{}: recording to {}", session->portName().toStdString(), fileName.toStdString());
+    } else {
+        logger->error("{}: cannot start record {}", session->portName().toStdString(), fileName.toStdString());
+    }
+}
+
+/**
+ * @brief Порт закрыт после ошибки - переподключить через ReconnectInterval. Запись продолжится в новый файл
+ */
+void AcquisitionDaemon::Closed(const QString &portName, const QString &error) {
+    if (m_stopping || error.isEmpty() || !m_ports.contains(portName)) {
+        return;
+    }
+
+    logger->warn("{}: reconnect in {} ms", portName.toStdString(), ReconnectInterval);
+    QTimer::singleShot(ReconnectInterval, this, [this, portName]() {
+        if (!m_stopping) {
+            m_devices->open(portName);
+        }
+    });
+}
+
+void AcquisitionDaemon::Status() {
+    for (const auto &portName : std::as_const(m_ports)) {
+        auto session = m_devices->session(portName);
+        if (session == nullptr) {
+            logger->info("{}: disconnected", portName.toStdString());
+            continue;
+        }
+
+        const auto &summary = session->summary();
+        const auto frames = session->worker()->frameStats();
+        const auto commands = session->worker()->commandStats();
+        logger->info("{}: {:.2f} °C, {:.3f} A, {:.1f} frames/s, lost {} ({:.2f}%), timeouts {}, record {:.1f} s",
+                     portName.toStdString(), summary.temperature, summary.current, summary.framesPerSecond,
+                     frames.lost, frames.lossRate() * 100, commands.timeouts, session->recordedTime());
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef ACQUISITIONDAEMON_H
+#define ACQUISITIONDAEMON_H
+
+#include <csignal>
+#include <memory>
+#include <optional>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include "spdlog/spdlog.h"
+#include "devicemanager.h"
+#include "deviceparameters.h"
+
+/**
+ * @brief Сбор телеметрии без интерфейса (qpeltierd)
+ *
+ * Подключается к заданным портам (или ко всем найденным), записывает профиль параметров в каждый
+ * контроллер и пишет телеметрию каждого устройства в свой файл. Порт с ошибкой переподключается.
+ * SIGTERM/SIGINT только поднимают флаг, остановка выполняется в цикле событий: записи дописываются
+ * и закрываются, порты закрываются, затем испускается finished().
+ */
+class AcquisitionDaemon : public QObject {
+    Q_OBJECT
+
+public:
+    struct Options {
+        QStringList ports;                  ///< Пусто - все найденные порты
+        std::optional<ParameterSet> profile;
+        QString outputDir = ".";
+        bool record = true;
+        int statusInterval = 10;            ///< Период вывода состояния в журнал, с. 0 - не выводить
+    };
+
+    static constexpr int SignalPollInterval = 200;     ///< Период проверки флага сигнала, мс
+    static constexpr int ReconnectInterval = 5000;     ///< Пауза перед переподключением порта с ошибкой, мс
+
+    AcquisitionDaemon(DeviceManager *devices, Options options, QObject *parent = nullptr);
+
+    bool start();
+    void stop();
+
+    static void installSignalHandlers();
+
+signals:
+    void finished();
+
+private:
+    std::shared_ptr<spdlog::logger> logger;
+    DeviceManager *m_devices;
+    Options m_options;
+    QStringList m_ports;                    ///< Порты сбора, переподключаются после ошибки
+    bool m_stopping = false;
+
+    QTimer m_signalTimer;
+    QTimer m_statusTimer;
+
+    static volatile std::sig_atomic_t s_signal;
+    static void SignalHandler(int signal);
+
+    void Opened(DeviceSession *session);
+    void Closed(const QString &portName, const QString &error);
+    void StartRecording(DeviceSession *session);
+    void Status();
+};
+
+#endif // ACQUISITIONDAEMON_H
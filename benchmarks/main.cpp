@@ -0,0 +1,18 @@
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+
+int main(int argc, char **argv) {
+    // Классы проекта берут логгеры по имени, в замерах вывод не нужен
+    for (const auto name : {"IO", "Serial", "Wake"}) {
+        spdlog::create<spdlog::sinks::null_sink_mt>(name);
+    }
+
+    ::benchmark::Initialize(&argc, argv);
+    if (::benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    ::benchmark::RunSpecifiedBenchmarks();
+    ::benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "wake.h"
+
+namespace {
+
+/**
+ * @brief 1 МБ кадров телеметрии: 94 байта данных, как у TelemetryFrame, со случайным током
+ */
+const std::vector<uint8_t> &TelemetryStream() {
+static const std::vector<uint8_t> stream = []() {
+    std::mt19937 rng(1);
+    std::vector<uint8_t> s;
+    while (s.size() < (1u << 20)) {
+        QByteArray data(94, Qt::Uninitialized);
+        for (auto &b : data) {
+            b = static_cast<char>(rng());
+        }
+        const auto tx = Wake::PrepareTx(0x05, data);
+        s.insert(s.end(), tx.begin(), tx.end());
+    }
+    return s;
+}();
+    return stream;
+}
+
+}
+
+static void BM_WakeProcessInByte(benchmark::State &state) {
+const auto &stream = TelemetryStream();
+Wake wake;
+    for (auto _ : state) {
+        int frames = 0;
+        for (auto b : stream) {
+            frames += wake.ProcessInByte(b) == Wake::READY;
+        }
+        benchmark::DoNotOptimize(frames);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * stream.size());
+}
+BENCHMARK(BM_WakeProcessInByte);
+
+/// Блоками размера чтения из порта, range(0) байт
+static void BM_WakeProcess(benchmark::State &state) {
+const auto &stream = TelemetryStream();
+const size_t block = state.range(0);
+Wake wake;
+    for (auto _ : state) {
+        size_t frames = 0;
+        for (size_t pos = 0; pos < stream.size(); pos += block) {
+            const size_t n = std::min(block, stream.size() - pos);
+            frames += wake.process(stream.data() + pos, stream.data() + pos + n).size();
+        }
+        benchmark::DoNotOptimize(frames);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * stream.size());
+}
+BENCHMARK(BM_WakeProcess)->Arg(64)->Arg(4096)->Arg(64 * 1024);
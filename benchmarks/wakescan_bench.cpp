@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "wake.h"
+#include "wakescan.h"
+
+namespace {
+
+constexpr uint8_t TelemetryCommand = 0x05;     ///< Команда на разбор не влияет
+constexpr size_t FrameSamples = 40;             ///< Отсчётов тока в кадре телеметрии
+
+/**
+ * @brief Поток кадров телеметрии, восстановленный из записей Utils/Results/Record-*.csv
+ *
+ * Столбец тока (А, десятичная запятая) раскладывается по 40 отсчётов в кадр с размещением TelemetryFrame:
+ * счётчик, ток в мА, температура, резерв, статус. Кадры кодируются в Wake, как их передаёт контроллер.
+ */
+const std::vector<uint8_t> &RecordStream() {
+static const std::vector<uint8_t> stream = []() {
+    std::vector<int16_t> current;
+    for (const auto &entry : std::filesystem::directory_iterator(QPELTIERUI_RESULTS_DIR)) {
+        const auto name = entry.path().filename().string();
+        if (name.rfind("Record-", 0) != 0 || entry.path().extension() != ".csv") {
+            continue;
+        }
+
+        std::ifstream file(entry.path());
+        std::string line;
+        std::getline(file, line);       // Заголовок
+        while (std::getline(file, line)) {
+            auto column = line.rfind(';');
+            if (column == std::string::npos) {
+                continue;
+            }
+            auto value = line.substr(column + 1);
+            std::replace(value.begin(), value.end(), ',', '.');
+            current.push_back(static_cast<int16_t>(std::lround(std::stod(value) * 1000)));
+        }
+    }
+
+    std::vector<uint8_t> s;
+    uint16_t counter = 0;
+    const float temperature = 25.0f;
+    const uint32_t zero = 0;
+    for (size_t i = 0; i + FrameSamples <= current.size(); i += FrameSamples) {
+        std::array<uint8_t, 94> payload;
+        uint8_t *p = payload.data();
+        ::memcpy(p, &counter, sizeof(counter));
+        p += sizeof(counter);
+        ::memcpy(p, current.data() + i, FrameSamples * sizeof(int16_t));
+        p += FrameSamples * sizeof(int16_t);
+        ::memcpy(p, &temperature, sizeof(temperature));
+        p += sizeof(temperature);
+        ::memcpy(p, &zero, sizeof(zero));
+        p += sizeof(zero);
+        ::memcpy(p, &zero, sizeof(zero));
+        counter++;
+
+        const auto frame = Wake::Encode(TelemetryCommand, payload);
+        const auto bytes = frame.bytes();
+        s.insert(s.end(), bytes.begin(), bytes.end());
+    }
+    return s;
+}();
+    return stream;
+}
+
+template <typename Find>
+void Scan(benchmark::State &state, Find find) {
+const auto &stream = RecordStream();
+    if (stream.empty()) {
+        state.SkipWithError("No Utils/Results/Record-*.csv");
+        return;
+    }
+
+    for (auto _ : state) {
+        size_t delimiters = 0;
+        const uint8_t *p = stream.data();
+        const uint8_t *end = p + stream.size();
+        while ((p = find(p, end)) < end) {
+            delimiters++;
+            p++;
+        }
+        benchmark::DoNotOptimize(delimiters);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * stream.size());
+}
+
+}
+
+static void BM_WakescanScalar(benchmark::State &state) {
+    Scan(state, wakescan::findScalar);
+}
+BENCHMARK(BM_WakescanScalar);
+
+static void BM_WakescanFind(benchmark::State &state) {
+    state.SetLabel(wakescan::implementation());
+    Scan(state, wakescan::find);
+}
+BENCHMARK(BM_WakescanFind);
+
+static void BM_RecordProcessInByte(benchmark::State &state) {
+const auto &stream = RecordStream();
+Wake wake;
+    for (auto _ : state) {
+        int frames = 0;
+        for (auto b : stream) {
+            frames += wake.ProcessInByte(b) == Wake::READY;
+        }
+        benchmark::DoNotOptimize(frames);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * stream.size());
+}
+BENCHMARK(BM_RecordProcessInByte);
+
+static void BM_RecordProcess(benchmark::State &state) {
+const auto &stream = RecordStream();
+Wake wake;
+    for (auto _ : state) {
+        size_t frames = 0;
+        for (size_t pos = 0; pos < stream.size(); pos += 4096) {
+            const size_t n = std::min<size_t>(4096, stream.size() - pos);
+            frames += wake.process(stream.data() + pos, stream.data() + pos + n).size();
+        }
+        benchmark::DoNotOptimize(frames);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * stream.size());
+}
+BENCHMARK(BM_RecordProcess);
@@ -0,0 +1,236 @@
+#ifndef COMMANDDESCRIPTORS_H
+#define COMMANDDESCRIPTORS_H
+
+#include <array>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include "wake.h"
+#include <proto.hpp>
+#include <commands.hpp>
+
+/**
+ * @brief Описание команд контроллера: данные запросов чтения и записи, данные ответа и единицы
+ *
+ * Кодирование, разбор и проверка ответов выводятся из описания при компиляции. Новая команда с данными
+ * фиксированного размера - это одна структура-описатель и строка в Registry. Команды с данными переменной длины
+ * (ключ защиты) описателей не имеют и отправляются через SerialPortWorker::request().
+ */
+namespace tecdesc {
+
+/// Представление поля на линии: числа - как есть (little-endian), перечисления - один байт
+template <typename T>
+struct Wire {
+    static_assert(std::is_arithmetic_v<T>, "Field must be arithmetic or enum");
+    static constexpr size_t size = sizeof(T);
+
+    static void store(uint8_t *p, T v) { ::memcpy(p, &v, sizeof(v)); }
+    static T load(const uint8_t *p) {
+        T v;
+        ::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    static constexpr bool valid(T) { return true; }
+};
+
+/// Допустимые значения перечисления в ответе
+template <typename E>
+struct EnumValues;
+
+template <>
+struct EnumValues<PidVariableType> {
+    static constexpr std::array values = {
+        PidVariableType::Proportional, PidVariableType::Integral, PidVariableType::Derivative, PidVariableType::WindUp
+    };
+};
+
+template <>
+struct EnumValues<WorkMode> {
+    static constexpr std::array values = {
+        WorkMode::Stopped, WorkMode::CurrentSource, WorkMode::TemperatureStab, WorkMode::Debug
+    };
+};
+
+template <typename T> requires std::is_enum_v<T>
+struct Wire<T> {
+    static constexpr size_t size = 1;
+
+    static void store(uint8_t *p, T v) { *p = static_cast<uint8_t>(v); }
+    static T load(const uint8_t *p) { return static_cast<T>(*p); }
+    static constexpr bool valid(T v) {
+        for (auto e : EnumValues<T>::values) {
+            if (e == v) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * @brief Данные команды или ответа: поля подряд, без выравнивания
+ */
+template <typename... Fields>
+struct Layout {
+    using Tuple = std::tuple<Fields...>;
+    static constexpr size_t size = (Wire<Fields>::size + ... + 0);
+    static constexpr size_t count = sizeof...(Fields);
+
+    static std::array<uint8_t, size> pack(const Fields &... fields) {
+        std::array<uint8_t, size> out{};
+        [[maybe_unused]] size_t offset = 0;
+        ((Wire<Fields>::store(out.data() + offset, fields), offset += Wire<Fields>::size), ...);
+        return out;
+    }
+
+    /// Разбор с проверкой размера и значений перечислений. Данные не копируются, кроме самих полей
+    static std::optional<Tuple> unpack(std::span<const uint8_t> data) {
+        if (data.size() != size) {
+            return std::nullopt;
+        }
+
+        [[maybe_unused]] size_t offset = 0;
+        Tuple fields{Load<Fields>(data.data(), offset)...};     // Порядок вычисления в {} - слева направо
+        const bool valid = std::apply([](const auto &... f) {
+            return (Wire<std::decay_t<decltype(f)>>::valid(f) && ... && true);
+        }, fields);
+        return valid ? std::optional<Tuple>(fields) : std::nullopt;
+    }
+
+private:
+    template <typename T>
+    static T Load(const uint8_t *p, size_t &offset) {
+        T v = Wire<T>::load(p + offset);
+        offset += Wire<T>::size;
+        return v;
+    }
+};
+
+template <typename L>
+struct FirstField {
+    using Type = void;
+};
+
+template <typename F, typename... Fields>
+struct FirstField<Layout<F, Fields...>> {
+    using Type = F;
+};
+
+/**
+ * @brief Описатель команды
+ * @tparam Cmd - команда
+ * @tparam Read - данные запроса чтения
+ * @tparam Write - данные запроса записи, void - команда только читает
+ * @tparam Reply - данные ответа
+ */
+template <tec::Commands Cmd, typename Read, typename Write, typename Reply>
+struct Descriptor {
+    static constexpr tec::Commands command = Cmd;
+    using ReadRequest = Read;
+    using WriteRequest = Write;
+    using ReplyLayout = Reply;
+
+    static constexpr bool writable = !std::is_void_v<Write>;
+
+    /// Ответ начинается с первого поля запроса (тип PID), по нему различаются одновременные запросы
+    static constexpr bool keyed = Read::count > 0 &&
+        std::is_same_v<typename FirstField<Read>::Type, typename FirstField<Reply>::Type>;
+
+    template <typename... Args>
+    static auto read(const Args &... args) {
+        return Wake::Encode(qToUnderlying(Cmd), Read::pack(args...));
+    }
+
+    template <typename... Args> requires writable
+    static auto write(const Args &... args) {
+        return Wake::Encode(qToUnderlying(Cmd), Write::pack(args...));
+    }
+
+    static std::optional<typename Reply::Tuple> decode(std::span<const uint8_t> data) {
+        return Reply::unpack(data);
+    }
+};
+
+struct OutputVoltage : Descriptor<tec::Commands::VoltageGetSet, Layout<>, Layout<float>, Layout<float>> {
+    static constexpr const char *unit = "%";
+};
+
+struct CurrentPid : Descriptor<tec::Commands::CurrentPidGetSet,
+                               Layout<PidVariableType>, Layout<PidVariableType, float>, Layout<PidVariableType, float>> {
+    static constexpr const char *unit = "";
+};
+
+struct TemperaturePid : Descriptor<tec::Commands::TemperaturePidGetSet,
+                                   Layout<PidVariableType>, Layout<PidVariableType, float>, Layout<PidVariableType, float>> {
+    static constexpr const char *unit = "";
+};
+
+struct TemperatureSetpoint : Descriptor<tec::Commands::TemperatureStabGetSet, Layout<>, Layout<float>, Layout<float>> {
+    static constexpr const char *unit = "°C";
+};
+
+struct DebugCurrent : Descriptor<tec::Commands::CurrentStabGetSet, Layout<>, Layout<float>, Layout<float>> {
+    static constexpr const char *unit = "A";
+};
+
+struct Mode : Descriptor<tec::Commands::WorkModeSetGet, Layout<>, Layout<WorkMode>, Layout<WorkMode>> {
+    static constexpr const char *unit = "";
+};
+
+struct Version : Descriptor<tec::Commands::VersionGet, Layout<>, void, Layout<uint32_t, uint32_t>> {
+    static constexpr const char *unit = "";
+};
+
+struct Save : Descriptor<tec::Commands::Save, Layout<>, void, Layout<>> {
+    static constexpr const char *unit = "";
+};
+
+/**
+ * @brief Набор описателей с выбором по коду команды, пришедшему во время работы
+ */
+template <typename... Descriptors>
+struct Table {
+    /// Вызвать f(Descriptor{}) для описателя команды. false - команда не описана
+    template <typename F>
+    static bool find(tec::Commands command, F &&f) {
+        return ((command == Descriptors::command ? (f(Descriptors{}), true) : false) || ...);
+    }
+
+    /// Разобрать ответ и вызвать visitor(Descriptor{}, поля...). false - команда не описана или ответ неверен
+    template <typename Visitor>
+    static bool decode(tec::Commands command, std::span<const uint8_t> data, Visitor &&visitor) {
+        bool decoded = false;
+        find(command, [&](auto descriptor) {
+            if (auto fields = decltype(descriptor)::decode(data)) {
+                std::apply([&](const auto &... f) {
+                    visitor(descriptor, f...);
+                }, *fields);
+                decoded = true;
+            }
+        });
+        return decoded;
+    }
+
+    /// Ключ ответа для запроса с данными payload: первый байт для команд с keyed, иначе -1
+    static int replyKey(tec::Commands command, std::span<const uint8_t> payload) {
+        int key = -1;
+        find(command, [&](auto descriptor) {
+            if (decltype(descriptor)::keyed && !payload.empty()) {
+                key = payload[0];
+            }
+        });
+        return key;
+    }
+};
+
+using Registry = Table<OutputVoltage, CurrentPid, TemperaturePid, TemperatureSetpoint, DebugCurrent, Mode, Version, Save>;
+
+inline std::span<const uint8_t> bytes(const QByteArray &data) {
+    return std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(data.constData()), data.size());
+}
+
+}
+
+#endif // COMMANDDESCRIPTORS_H
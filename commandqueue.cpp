@@ -0,0 +1,52 @@
+#include "commandqueue.h"
+
+
+/**
+ * @brief Поставить запрос в конец очереди
+ * @return false, если очередь переполнена
+ */
+bool CommandQueue::enqueue(CommandRequest &&request) {
+    if (m_pending.size() >= PendingMaximum) {
+        return false;
+    }
+
+    m_pending.push_back(std::move(request));
+    return true;
+}
+
+/**
+ * @brief Найти и снять запрос, к которому относится ответ
+ * @param[in] command - код команды ответа
+ * @param[in] key - первый байт ответа для команд с ключом, иначе -1
+ * @param[out] request - снятый запрос
+ * @return false, если ответ не ожидался
+ */
+bool CommandQueue::complete(uint8_t command, int key, CommandRequest &request) {
+    for (auto it = m_inFlight.begin(); it != m_inFlight.end(); ++it) {
+        if (it->command == command && (it->key < 0 || it->key == key)) {
+            request = std::move(*it);
+            m_inFlight.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Время до ближайшего события очереди, мс
+ * @return 0 - есть что передать, -1 - ждать нечего
+ */
+qint64 CommandQueue::nextTimeout() const {
+    if (!m_pending.empty() && m_inFlight.size() < m_window) {
+        return 0;
+    }
+
+qint64 timeout = -1;
+    for (const auto &request : m_inFlight) {
+        const qint64 remaining = std::max<qint64>(request.deadline.remainingTime(), 0);
+        if (timeout < 0 || remaining < timeout) {
+            timeout = remaining;
+        }
+    }
+    return timeout;
+}
@@ -0,0 +1,112 @@
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <algorithm>
+#include <deque>
+#include <QByteArray>
+#include <QDeadlineTimer>
+
+/**
+ * @brief Запрос к контроллеру в очереди команд
+ */
+struct CommandRequest {
+    uint32_t id = 0;            ///< Номер запроса, уникален в пределах SerialPortWorker
+    uint8_t command = 0;        ///< tec::Commands
+    int key = -1;               ///< Первый байт ответа, если команда его повторяет (тип PID), иначе -1
+    QByteArray payload;         ///< Данные команды без обрамления
+    QByteArray tx;              ///< Готовый кадр Wake
+    qint64 timeout = 1000;      ///< Ожидание ответа на одну передачу, мс
+    int retries = 0;            ///< Оставшиеся повторы при таймауте
+    int attempts = 0;           ///< Выполненные передачи
+    QDeadlineTimer deadline;
+};
+
+/**
+ * @brief Очередь команд с несколькими запросами в полёте
+ *
+ * Ответ несёт только код команды (и тип PID), поэтому ответ сопоставляется с самым старым запросом в полёте
+ * с тем же кодом и ключом: контроллер отвечает на команды по порядку. Запрос без ответа за timeout передаётся
+ * заново, пока не исчерпаны повторы, и встаёт в начало очереди.
+ *
+ * Класс не потокобезопасен, блокировка - у владельца.
+ */
+class CommandQueue {
+public:
+    void setWindow(size_t window) { m_window = std::max<size_t>(window, 1); }
+    size_t window() const { return m_window; }
+
+    bool enqueue(CommandRequest &&request);
+
+    /**
+     * @brief Передать ожидающие запросы, пока есть место в окне
+     * @param[in] write - вызывается как write(const CommandRequest &) для каждой передачи
+     */
+    template <typename Write>
+    void transmit(Write &&write) {
+        while (m_inFlight.size() < m_window && !m_pending.empty()) {
+            m_inFlight.push_back(std::move(m_pending.front()));
+            m_pending.pop_front();
+
+            auto &request = m_inFlight.back();
+            request.attempts++;
+            request.deadline.setRemainingTime(request.timeout);
+            write(static_cast<const CommandRequest &>(request));
+        }
+    }
+
+    /**
+     * @brief Обработать истёкшие запросы: с оставшимися повторами - в начало очереди, иначе - отказ
+     * @param[in] failed - вызывается как failed(CommandRequest &&) для запросов без повторов
+     */
+    template <typename Failed>
+    void expire(Failed &&failed) {
+        for (auto it = m_inFlight.begin(); it != m_inFlight.end();) {
+            if (!it->deadline.hasExpired()) {
+                ++it;
+                continue;
+            }
+
+            CommandRequest request = std::move(*it);
+            it = m_inFlight.erase(it);
+            if (request.retries > 0) {
+                request.retries--;
+                m_retransmits++;
+                m_pending.push_front(std::move(request));
+            } else {
+                failed(std::move(request));
+            }
+        }
+    }
+
+    bool complete(uint8_t command, int key, CommandRequest &request);
+
+    /// Отказ всем запросам, например при закрытии порта
+    template <typename Failed>
+    void clear(Failed &&failed) {
+        for (auto &request : m_inFlight) {
+            failed(std::move(request));
+        }
+        for (auto &request : m_pending) {
+            failed(std::move(request));
+        }
+        m_inFlight.clear();
+        m_pending.clear();
+    }
+
+    qint64 nextTimeout() const;
+
+    size_t inFlight() const { return m_inFlight.size(); }
+    size_t pending() const { return m_pending.size(); }
+    bool hasWork() const { return !m_inFlight.empty() || !m_pending.empty(); }
+    uint64_t retransmits() const { return m_retransmits; }
+
+private:
+    static constexpr size_t PendingMaximum = 256;
+
+    std::deque<CommandRequest> m_pending;
+    std::deque<CommandRequest> m_inFlight;   ///< В порядке передачи
+    size_t m_window = 4;
+    uint64_t m_retransmits = 0;
+};
+
+#endif // COMMANDQUEUE_H
@@ -0,0 +1,131 @@
+#ifndef CRC8_H
+#define CRC8_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief CRC-8 Maxim (полином 0x31, отражённый 0x8C, начальное значение 0), используется в кадрах Wake
+ *
+ * Вариант расчёта выбирается при компиляции параметром шаблона compute<>() или макросом CRC8_DEFAULT_ENGINE.
+ */
+namespace crc8 {
+
+enum class Engine {
+    Bitwise,    ///< 8 итераций на байт, эталон
+    Table,      ///< Таблица на 256 элементов, одна выборка на байт
+    SliceBy4,   ///< 4 таблицы, 4 байта за шаг
+    SliceBy8    ///< 8 таблиц, 8 байт за шаг
+};
+
+#ifndef CRC8_DEFAULT_ENGINE
+#define CRC8_DEFAULT_ENGINE SliceBy8
+#endif
+
+inline constexpr Engine DefaultEngine = Engine::CRC8_DEFAULT_ENGINE;
+
+/**
+ * @brief Побитовый расчёт одного байта
+ */
+constexpr uint8_t updateBitwise(uint8_t crc, uint8_t b) {
+    for (uint8_t i = 0; i < 8; b = b >> 1, i++) {
+        if ((b ^ crc) & 1) {
+            crc = ((crc ^ 0x18) >> 1) | 0x80;
+        } else {
+            crc = (crc >> 1) & ~0x80;
+        }
+    }
+    return crc;
+}
+
+using TableSet = std::array<std::array<uint8_t, 256>, 8>;
+
+/**
+ * @brief Таблицы для slice-by-N: Tables[k][i] - CRC байта i, за которым следуют k нулевых байт
+ */
+constexpr TableSet makeTables() {
+TableSet t{};
+    for (int i = 0; i < 256; i++) {
+        t[0][i] = updateBitwise(0, static_cast<uint8_t>(i));
+    }
+    for (int k = 1; k < 8; k++) {
+        for (int i = 0; i < 256; i++) {
+            t[k][i] = t[0][t[k - 1][i]];
+        }
+    }
+    return t;
+}
+
+inline constexpr TableSet Tables = makeTables();
+
+/**
+ * @brief Табличный расчёт одного байта
+ */
+constexpr uint8_t update(uint8_t crc, uint8_t b) {
+    return Tables[0][crc ^ b];
+}
+
+/**
+ * @brief CRC блока данных
+ * @param[in] crc - текущее значение CRC
+ * @param[in] data - данные
+ * @param[in] size - размер данных, байт
+ * @return Новое значение CRC
+ */
+template <Engine E = DefaultEngine>
+constexpr uint8_t compute(uint8_t crc, const uint8_t *data, size_t size) {
+    if constexpr (E == Engine::SliceBy8) {
+        for (; size >= 8; size -= 8, data += 8) {
+            crc = Tables[7][crc ^ data[0]] ^ Tables[6][data[1]] ^ Tables[5][data[2]] ^ Tables[4][data[3]] ^
+                  Tables[3][data[4]] ^ Tables[2][data[5]] ^ Tables[1][data[6]] ^ Tables[0][data[7]];
+        }
+    } else if constexpr (E == Engine::SliceBy4) {
+        for (; size >= 4; size -= 4, data += 4) {
+            crc = Tables[3][crc ^ data[0]] ^ Tables[2][data[1]] ^ Tables[1][data[2]] ^ Tables[0][data[3]];
+        }
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        if constexpr (E == Engine::Bitwise) {
+            crc = updateBitwise(crc, data[i]);
+        } else {
+            crc = update(crc, data[i]);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Сверка всех вариантов с побитовым расчётом на псевдослучайных буферах длиной 0..160 байт
+ */
+constexpr bool selfTest() {
+uint32_t seed = 0x12345678;
+std::array<uint8_t, 160> buf{};
+    for (size_t len = 0; len <= buf.size(); len++) {
+        for (size_t i = 0; i < len; i++) {
+            seed = seed * 1664525u + 1013904223u;
+            buf[i] = static_cast<uint8_t>(seed >> 24);
+        }
+        const auto init = static_cast<uint8_t>(len * 37);
+        const auto ref = compute<Engine::Bitwise>(init, buf.data(), len);
+        if (compute<Engine::Table>(init, buf.data(), len) != ref ||
+            compute<Engine::SliceBy4>(init, buf.data(), len) != ref ||
+            compute<Engine::SliceBy8>(init, buf.data(), len) != ref) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr uint8_t checkValue() {
+const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    return compute<Engine::Bitwise>(0, check, sizeof(check));
+}
+
+static_assert(checkValue() == 0xA1, "CRC-8 Maxim check value mismatch");
+static_assert(selfTest(), "CRC-8 table engines differ from bitwise reference");
+
+} // namespace crc8
+
+#endif // CRC8_H
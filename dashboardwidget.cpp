@@ -0,0 +1,173 @@
+#include <cmath>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QVBoxLayout>
+#include "dashboardwidget.h"
+
+
+DashboardWidget::DashboardWidget(DeviceManager *devices, QWidget *parent) : m_devices(devices), QWidget(parent, Qt::Window) {
+    logger = spdlog::get("QPeltierUI");
+    setWindowTitle(tr("Dashboard"));
+    resize(900, 480);
+
+    m_table = new QTableWidget(0, ColumnCount, this);
+    m_table->setHorizontalHeaderLabels({tr("Port"), tr("State"), tr("Temperature, °C"), tr("Current, A"), tr("Frames/s"),
+                                        tr("Lost"), tr("Commands"), tr("Record")});
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    m_table->verticalHeader()->hide();
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    connect(m_table, &QTableWidget::cellDoubleClicked, this, [this](int row, int) {
+        emit showDevice(m_table->item(row, ColumnPort)->data(Qt::UserRole).toString());
+    });
+
+    m_btnRefresh = new QPushButton(tr("Refresh"), this);
+    m_btnConnectAll = new QPushButton(tr("Connect all"), this);
+    m_btnDisconnectAll = new QPushButton(tr("Disconnect all"), this);
+    m_btnRecordAll = new QPushButton(tr("Record all"), this);
+    connect(m_btnRefresh, &QPushButton::clicked, this, &DashboardWidget::PopulatePorts);
+    connect(m_btnConnectAll, &QPushButton::clicked, this, [this]() {
+        for (const auto &p : m_devices->availablePorts()) {
+            m_errors.remove(p.second);
+            m_devices->open(p.second);
+        }
+        Update();
+    });
+    connect(m_btnDisconnectAll, &QPushButton::clicked, this, [this]() {
+        m_devices->closeAll();
+        Update();
+    });
+    connect(m_btnRecordAll, &QPushButton::clicked, this, &DashboardWidget::RecordAll);
+
+auto buttons = new QHBoxLayout();
+    buttons->addWidget(m_btnRefresh);
+    buttons->addWidget(m_btnConnectAll);
+    buttons->addWidget(m_btnDisconnectAll);
+    buttons->addWidget(m_btnRecordAll);
+    buttons->addStretch();
+
+auto layout = new QVBoxLayout(this);
+    layout->addLayout(buttons);
+    layout->addWidget(m_table);
+
+    connect(m_devices, &DeviceManager::closed, this, [this](const QString &portName, const QString &error) {
+        if (!error.isEmpty()) {
+            m_errors[portName] = error;
+        }
+    });
+    connect(&m_updateTimer, &QTimer::timeout, this, &DashboardWidget::Update);
+
+    PopulatePorts();
+}
+
+/**
+ * @brief Заново получить список портов. Строки подключённых устройств сохраняются
+ */
+void DashboardWidget::PopulatePorts() {
+    m_table->setRowCount(0);
+    m_rows.clear();
+    for (const auto &p : m_devices->availablePorts()) {
+        Row(p.second);
+    }
+    Update();
+}
+
+int DashboardWidget::Row(const QString &portName) {
+    if (auto it = m_rows.constFind(portName); it != m_rows.constEnd()) {
+        return *it;
+    }
+
+int row = m_table->rowCount();
+    m_table->insertRow(row);
+    for (int c = 0; c < ColumnCount; c++) {
+        m_table->setItem(row, c, new QTableWidgetItem());
+    }
+    m_table->item(row, ColumnPort)->setText(portName);
+    m_table->item(row, ColumnPort)->setData(Qt::UserRole, portName);
+    m_rows.insert(portName, row);
+    return row;
+}
+
+void DashboardWidget::SetCell(int row, Column column, const QString &text) {
+auto item = m_table->item(row, column);
+    if (item->text() != text) {
+        item->setText(text);
+    }
+}
+
+void DashboardWidget::Update() {
+    for (auto session : m_devices->sessions()) {
+        Row(session->portName());
+    }
+
+    for (auto it = m_rows.constBegin(); it != m_rows.constEnd(); ++it) {
+        const int row = it.value();
+        auto session = m_devices->session(it.key());
+        if (session == nullptr) {
+            SetCell(row, ColumnState, m_errors.contains(it.key()) ? tr("Error: %1").arg(m_errors[it.key()]) : tr("Disconnected"));
+            for (int c = ColumnTemperature; c < ColumnCount; c++) {
+                SetCell(row, static_cast<Column>(c), QString());
+            }
+            continue;
+        }
+
+        const auto &summary = session->summary();
+        const auto silent = session->sinceLastFrame();
+        SetCell(row, ColumnState, silent < 0 ? tr("Waiting") : silent > StaleTimeout ? tr("No telemetry %1 s").arg(silent / 1000) : tr("Connected"));
+        SetCell(row, ColumnTemperature, std::isnan(summary.temperature) ? QString() : QString::number(summary.temperature, 'f', 2));
+        SetCell(row, ColumnCurrent, std::isnan(summary.current) ? QString() : QString::number(summary.current, 'f', 3));
+        SetCell(row, ColumnRate, QString::number(summary.framesPerSecond, 'f', 1));
+
+        const auto frames = session->worker()->frameStats();
+        SetCell(row, ColumnLost, QString("%1 (%2%)").arg(frames.lost).arg(frames.lossRate() * 100, 0, 'f', 2));
+
+        const auto commands = session->worker()->commandStats();
+        auto commandsText = QString("%1/%2, timeouts %3").arg(commands.inFlight).arg(commands.pending).arg(commands.timeouts);
+        if (session->worker()->address() != Wake::NoAddress) {
+            commandsText += QString(", polls lost %1").arg(commands.pollTimeouts);
+        }
+        SetCell(row, ColumnCommands, commandsText);
+
+        SetCell(row, ColumnRecord, session->isRecording() ?
+            QString("%1 - %2 s").arg(session->recordFileName()).arg(session->recordedTime(), 0, 'f', 1) : QString());
+    }
+
+bool recording = false;
+    for (auto session : m_devices->sessions()) {
+        recording |= session->isRecording();
+    }
+    m_btnRecordAll->setText(recording ? tr("Stop all records") : tr("Record all"));
+    m_btnRecordAll->setEnabled(m_devices->count() > 0);
+    m_btnDisconnectAll->setEnabled(m_devices->count() > 0);
+}
+
+/**
+ * @brief Начать запись всех подключённых устройств, каждое в свой файл, или остановить все записи
+ */
+void DashboardWidget::RecordAll() {
+bool recording = false;
+    for (auto session : m_devices->sessions()) {
+        recording |= session->isRecording();
+    }
+
+    for (auto session : m_devices->sessions()) {
+        if (recording) {
+            session->stopRecording();
+        } else if (!session->startRecording(DeviceSession::recordFileName(session->portName()))) {
+            logger->error("Cannot start record for {}", session->portName().toStdString());
+        }
+    }
+    Update();
+}
+
+void DashboardWidget::showEvent(QShowEvent *event) {
+    QWidget::showEvent(event);
+    Update();
+    m_updateTimer.start(UpdateInterval);
+}
+
+void DashboardWidget::hideEvent(QHideEvent *event) {
+    m_updateTimer.stop();
+    QWidget::hideEvent(event);
+}
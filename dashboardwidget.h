@@ -0,0 +1,67 @@
+#ifndef DASHBOARDWIDGET_H
+#define DASHBOARDWIDGET_H
+
+#include <QHash>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QWidget>
+#include "spdlog/spdlog.h"
+#include "devicemanager.h"
+
+/**
+ * @brief Общая панель всех контроллеров: строка на порт со сводкой телеметрии, очереди команд и записи
+ *
+ * Таблица обновляется с частотой UpdateInterval независимо от числа кадров, графиков на устройство нет.
+ * Двойной щелчок по строке открывает устройство в подробном виде главного окна.
+ */
+class DashboardWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit DashboardWidget(DeviceManager *devices, QWidget *parent = nullptr);
+
+signals:
+    void showDevice(const QString &portName);
+
+private:
+    static constexpr int UpdateInterval = 250;     ///< Период обновления таблицы, мс
+    static constexpr qint64 StaleTimeout = 1000;   ///< Нет телеметрии дольше - устройство отмечается как молчащее, мс
+
+    enum Column {
+        ColumnPort,
+        ColumnState,
+        ColumnTemperature,
+        ColumnCurrent,
+        ColumnRate,
+        ColumnLost,
+        ColumnCommands,
+        ColumnRecord,
+        ColumnCount
+    };
+
+    DeviceManager *m_devices;
+    std::shared_ptr<spdlog::logger> logger;
+
+    QTableWidget *m_table;
+    QPushButton *m_btnRefresh;
+    QPushButton *m_btnConnectAll;
+    QPushButton *m_btnDisconnectAll;
+    QPushButton *m_btnRecordAll;
+    QTimer m_updateTimer;
+
+    QHash<QString, int> m_rows;                 ///< Строка таблицы по имени порта
+    QHash<QString, QString> m_errors;           ///< Последняя ошибка порта
+
+    void PopulatePorts();
+    int Row(const QString &portName);
+    void SetCell(int row, Column column, const QString &text);
+    void Update();
+    void RecordAll();
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+};
+
+#endif // DASHBOARDWIDGET_H
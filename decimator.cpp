@@ -0,0 +1,139 @@
+#include <cmath>
+#include <limits>
+#include "decimator.h"
+
+
+void Decimator::setMode(Mode mode) {
+    m_mode = mode;
+    invalidate();
+}
+
+void Decimator::invalidate() {
+    m_samplesPerColumn = 0;
+    m_columns.clear();
+}
+
+/**
+ * @brief Проредить отсчёты [begin, end)
+ * @param[in] ring - хранилище отсчётов
+ * @param[in] columns - ширина графика, пикселей
+ * @param[in] tick - период отсчёта, секунд
+ * @param[out] out - точки для серии, содержимое заменяется
+ */
+void Decimator::decimate(const SampleRing &ring, uint64_t begin, uint64_t end, int columns, double tick, QList<QPointF> &out) {
+    out.resize(0);
+    begin = std::max(begin, ring.first());
+    end = std::min(end, ring.total());
+    if (begin >= end) {
+        return;
+    }
+
+    columns = std::max(columns, 1);
+    if (end - begin <= static_cast<uint64_t>(columns) * 2) {
+        // Прореживать нечего
+        ring.forEachSpan(begin, end, [&](uint64_t index, const double *p, size_t n) {
+            for (size_t k = 0; k < n; k++) {
+                out.append(QPointF((index + k) * tick, p[k]));
+            }
+        });
+        return;
+    }
+
+    if (m_mode == Mode::Lttb) {
+        DecimateLttb(ring, begin, end, columns * 2, tick, out);
+    } else {
+        DecimateMinMax(ring, begin, end, columns, tick, out);
+    }
+}
+
+void Decimator::ComputeColumn(const SampleRing &ring, uint64_t begin, uint64_t end, Column &column) const {
+    column.min = std::numeric_limits<double>::max();
+    column.max = std::numeric_limits<double>::lowest();
+    column.minIndex = column.maxIndex = begin;
+    ring.forEachSpan(begin, end, [&](uint64_t index, const double *p, size_t n) {
+        for (size_t k = 0; k < n; k++) {
+            if (p[k] < column.min) {
+                column.min = p[k];
+                column.minIndex = index + k;
+            }
+            if (p[k] > column.max) {
+                column.max = p[k];
+                column.maxIndex = index + k;
+            }
+        }
+    });
+}
+
+void Decimator::DecimateMinMax(const SampleRing &ring, uint64_t begin, uint64_t end, int columns, double tick, QList<QPointF> &out) {
+    const uint64_t spc = (end - begin + columns - 1) / columns;
+    if (spc != m_samplesPerColumn || m_columns.size() < static_cast<size_t>(columns) + 2) {
+        m_samplesPerColumn = spc;
+        m_columns.assign(columns + 2, Column());
+    }
+
+    const uint64_t firstColumn = begin / spc;
+    const uint64_t lastColumn = (end - 1) / spc;
+    for (uint64_t c = firstColumn; c <= lastColumn; c++) {
+        auto &column = m_columns[c % m_columns.size()];
+        const uint64_t cb = c * spc;
+        const uint64_t ce = cb + spc;
+        // Первый столбец частично вытеснен из окна - его отсчёты меняются
+        if (column.id != c || !column.complete || cb < begin) {
+            ComputeColumn(ring, std::max(cb, begin), std::min(ce, end), column);
+            column.id = c;
+            column.complete = cb >= begin && ce <= end;
+        }
+
+        const QPointF pmin(column.minIndex * tick, column.min);
+        const QPointF pmax(column.maxIndex * tick, column.max);
+        if (column.minIndex == column.maxIndex) {
+            out.append(pmin);
+        } else if (column.minIndex < column.maxIndex) {
+            out.append(pmin);
+            out.append(pmax);
+        } else {
+            out.append(pmax);
+            out.append(pmin);
+        }
+    }
+}
+
+void Decimator::DecimateLttb(const SampleRing &ring, uint64_t begin, uint64_t end, int threshold, double tick, QList<QPointF> &out) {
+    const uint64_t count = end - begin;
+    const double bucket = static_cast<double>(count - 2) / (threshold - 2);
+
+    uint64_t a = begin;
+    out.append(QPointF(a * tick, ring.at(a)));
+    for (int i = 0; i < threshold - 2; i++) {
+        // Среднее следующей корзины - третья вершина треугольника
+        uint64_t nb = begin + static_cast<uint64_t>(std::floor((i + 1) * bucket)) + 1;
+        uint64_t ne = std::min(begin + static_cast<uint64_t>(std::floor((i + 2) * bucket)) + 1, end);
+        double avgX = 0;
+        double avgY = 0;
+        for (uint64_t j = nb; j < ne; j++) {
+            avgX += j;
+            avgY += ring.at(j);
+        }
+        const auto n = static_cast<double>(std::max<uint64_t>(ne - nb, 1));
+        avgX /= n;
+        avgY /= n;
+
+        const uint64_t rb = begin + static_cast<uint64_t>(std::floor(i * bucket)) + 1;
+        const uint64_t re = begin + static_cast<uint64_t>(std::floor((i + 1) * bucket)) + 1;
+        const double ax = static_cast<double>(a);
+        const double ay = ring.at(a);
+        double maxArea = -1;
+        uint64_t next = rb;
+        for (uint64_t j = rb; j < re; j++) {
+            const double area = std::abs((ax - avgX) * (ring.at(j) - ay) - (ax - j) * (avgY - ay));
+            if (area > maxArea) {
+                maxArea = area;
+                next = j;
+            }
+        }
+
+        out.append(QPointF(next * tick, ring.at(next)));
+        a = next;
+    }
+    out.append(QPointF((end - 1) * tick, ring.at(end - 1)));
+}
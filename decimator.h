@@ -0,0 +1,50 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <QList>
+#include <QPointF>
+#include <vector>
+#include "samplering.h"
+
+/**
+ * @brief Прореживание отсчётов самописца до ширины графика
+ *
+ * MinMax: окно делится на столбцы по числу пикселей, от каждого столбца остаются минимум и максимум в порядке
+ * следования, поэтому одиночные выбросы не пропадают. Столбцы выровнены по абсолютному номеру отсчёта:
+ * полностью заполненные столбцы запоминаются и при следующей перерисовке не пересчитываются.
+ *
+ * Lttb: Largest-Triangle-Three-Buckets, форма сигнала передаётся точнее, но окно пересчитывается целиком.
+ */
+class Decimator {
+public:
+    enum class Mode {
+        MinMax,
+        Lttb
+    };
+
+    void setMode(Mode mode);
+    Mode mode() const { return m_mode; }
+    void invalidate();
+
+    void decimate(const SampleRing &ring, uint64_t begin, uint64_t end, int columns, double tick, QList<QPointF> &out);
+
+private:
+    struct Column {
+        uint64_t id = UINT64_MAX;   ///< Номер столбца = номер первого отсчёта / m_samplesPerColumn
+        bool complete = false;      ///< Все отсчёты столбца уже приняты, пересчёт не нужен
+        double min;
+        double max;
+        uint64_t minIndex;
+        uint64_t maxIndex;
+    };
+
+    Mode m_mode = Mode::MinMax;
+    uint64_t m_samplesPerColumn = 0;
+    std::vector<Column> m_columns;  ///< Кэш столбцов, индекс - id % size
+
+    void ComputeColumn(const SampleRing &ring, uint64_t begin, uint64_t end, Column &column) const;
+    void DecimateMinMax(const SampleRing &ring, uint64_t begin, uint64_t end, int columns, double tick, QList<QPointF> &out);
+    void DecimateLttb(const SampleRing &ring, uint64_t begin, uint64_t end, int threshold, double tick, QList<QPointF> &out);
+};
+
+#endif // DECIMATOR_H
@@ -0,0 +1,227 @@
+#include "devicemanager.h"
+
+
+DeviceManager::DeviceManager(bool isSimulator, bool isNativeTty, QObject *parent) : m_isSimulator(isSimulator), m_isNativeTty(isNativeTty), QObject(parent) {
+    logger = spdlog::get("Serial");
+    connect(&m_drainTimer, &QTimer::timeout, this, &DeviceManager::Drain);
+}
+
+DeviceManager::~DeviceManager() {
+    closeAll();
+}
+
+/**
+ * @brief Порты для подключения: пары (название, имя порта). В режиме симулятора - имитируемые устройства
+ */
+QList<QPair<QString, QString>> DeviceManager::availablePorts() const {
+QList<QPair<QString, QString>> ports;
+    if (!m_isSimulator) {
+        ports = SerialPortWorker::availablePorts();
+    } else if (m_simulatorDevices == 1) {
+        ports.append(QPair(QString("Simulator"), QString("Simulator")));
+    } else {
+        for (int i = 1; i <= m_simulatorDevices; i++) {
+            const auto name = QString("Simulator %1").arg(i);
+            ports.append(QPair(name, name));
+        }
+    }
+
+    // Порт шины заменяется своими узлами. Шины, заданные явно, показываются и без найденного порта
+QList<QPair<QString, QString>> ret;
+    for (const auto &p : ports) {
+        if (!m_buses.contains(p.second)) {
+            ret.append(p);
+        }
+    }
+    for (auto it = m_buses.constBegin(); it != m_buses.constEnd(); ++it) {
+        for (auto address : it.value()) {
+            const auto name = nodeName(it.key(), address);
+            ret.append(QPair(name, name));
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief Объявить порт шиной RS-485 с контроллерами по адресам
+ * @param[in] portName - имя порта
+ * @param[in] addresses - адреса контроллеров, 1..127
+ */
+void DeviceManager::addBus(const QString &portName, const QList<uint8_t> &addresses) {
+    m_buses[portName] = addresses;
+    logger->info("Bus {}: {} nodes", portName.toStdString(), addresses.size());
+}
+
+/**
+ * @brief Разобрать описание шины из командной строки: "порт:адрес[,адрес...]"
+ * @param[out] portName - имя порта
+ * @param[out] addresses - адреса контроллеров, 1..127
+ * @return false, если описание неверно или адресов нет
+ */
+bool DeviceManager::parseBus(const QString &spec, QString &portName, QList<uint8_t> &addresses) {
+const auto colon = spec.lastIndexOf(':');
+    if (colon <= 0) {
+        return false;
+    }
+
+    portName = spec.left(colon);
+    addresses.clear();
+    for (const auto &a : spec.mid(colon + 1).split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        int address = a.toInt(&ok);
+        if (ok && address > 0 && address < 128) {
+            addresses.append(static_cast<uint8_t>(address));
+        }
+    }
+    return !addresses.isEmpty();
+}
+
+bool DeviceManager::SplitNode(const QString &name, QString &portName, int &address) {
+const auto at = name.lastIndexOf('@');
+    if (at <= 0) {
+        return false;
+    }
+
+bool ok = false;
+    address = name.mid(at + 1).toInt(&ok);
+    portName = name.left(at);
+    return ok;
+}
+
+/**
+ * @brief Подключиться к порту
+ * @return Сессия порта, уже открытая или новая
+ */
+DeviceSession *DeviceManager::open(const QString &portName) {
+    if (auto session = m_sessions.value(portName, nullptr)) {
+        return session;
+    }
+
+auto &cache = m_caches[portName];
+    if (!cache) {
+        cache = std::make_shared<ParameterCache>();
+    }
+
+SerialPortWorker *link = nullptr;
+QString linkName;
+int address = Wake::NoAddress;
+    if (SplitNode(portName, linkName, address) && m_buses.contains(linkName)) {
+        link = Link(linkName);
+    } else {
+        address = Wake::NoAddress;
+    }
+
+auto session = new DeviceSession(portName, m_isSimulator, m_isNativeTty, cache, link, address, this);
+    connect(session, &DeviceSession::error, this, &DeviceManager::SessionError);
+    m_sessions.insert(portName, session);
+    session->start();
+    if (!m_drainTimer.isActive()) {
+        m_drainTimer.start(DrainInterval);
+    }
+
+    logger->info("{} devices connected", m_sessions.size());
+    emit opened(session);
+    return session;
+}
+
+void DeviceManager::close(const QString &portName) {
+auto session = m_sessions.take(portName);
+    if (session == nullptr) {
+        return;
+    }
+
+    session->setSink({});
+    if (m_sessions.isEmpty()) {
+        m_drainTimer.stop();
+    }
+    emit closed(portName, QString());
+    delete session;
+
+QString linkName;
+int address;
+    if (SplitNode(portName, linkName, address)) {
+        ReleaseLink(linkName);
+    }
+}
+
+void DeviceManager::closeAll() {
+    for (const auto &portName : m_sessions.keys()) {
+        close(portName);
+    }
+}
+
+void DeviceManager::Drain() {
+    for (auto session : std::as_const(m_sessions)) {
+        session->drain();
+    }
+    emit drained();
+}
+
+void DeviceManager::SessionError(const QString &portName, const QString &s) {
+    logger->error("{}: {}", portName.toStdString(), s.toStdString());
+auto session = m_sessions.take(portName);
+    if (session == nullptr) {
+        return;
+    }
+
+    // Сигнал пришёл от самой сессии, удалять её здесь нельзя
+    session->setSink({});
+    session->deleteLater();
+    if (m_sessions.isEmpty()) {
+        m_drainTimer.stop();
+    }
+    emit closed(portName, s);
+
+QString linkName;
+int address;
+    if (SplitNode(portName, linkName, address)) {
+        ReleaseLink(linkName);
+    }
+}
+
+/**
+ * @brief Поток линии шины, создаётся при открытии первого узла
+ */
+SerialPortWorker *DeviceManager::Link(const QString &portName) {
+    if (auto link = m_links.value(portName, nullptr)) {
+        return link;
+    }
+
+auto link = new SerialPortWorker(m_isSimulator);
+    if (m_isNativeTty) {
+        link->setTransport(SerialPortWorker::Transport::NativeTty);
+    }
+    // Ошибка линии закрывает все её узлы
+    connect(link, &SerialPortWorker::error, this, [this, portName](const QString &s) {
+        const auto prefix = portName + '@';
+        for (const auto &name : m_sessions.keys()) {
+            if (name.startsWith(prefix)) {
+                SessionError(name, s);
+            }
+        }
+    }, static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::SingleShotConnection));
+    link->startReceiver(portName, 10);
+    m_links.insert(portName, link);
+    logger->info("Bus {} opened", portName.toStdString());
+    return link;
+}
+
+/**
+ * @brief Закрыть поток линии шины, если у неё не осталось открытых узлов
+ */
+void DeviceManager::ReleaseLink(const QString &portName) {
+    if (!m_links.contains(portName)) {
+        return;
+    }
+
+const auto prefix = portName + '@';
+    for (const auto &name : m_sessions.keys()) {
+        if (name.startsWith(prefix)) {
+            return;
+        }
+    }
+
+    // Узлы, удаляемые позже (deleteLater), линия отключит от себя сама
+    delete m_links.take(portName);
+    logger->info("Bus {} closed", portName.toStdString());
+}
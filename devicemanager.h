@@ -0,0 +1,70 @@
+#ifndef DEVICEMANAGER_H
+#define DEVICEMANAGER_H
+
+#include <memory>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QTimer>
+#include "spdlog/spdlog.h"
+#include "devicesession.h"
+
+/**
+ * @brief Все подключённые контроллеры процесса
+ *
+ * Открывает по сессии DeviceSession на порт и разбирает очереди телеметрии всех сессий одним таймером
+ * в потоке GUI: затраты растут линейно с числом устройств, отдельных таймеров и сигналов на кадр нет.
+ * Кэши параметров живут по имени порта между подключениями. Сессия с ошибкой порта закрывается.
+ *
+ * Контроллеры на шине RS-485 (addBus()) открываются как отдельные устройства "<порт>@<адрес>": линию ведёт
+ * общий поток порта, он создаётся с первым узлом и удаляется с последним.
+ */
+class DeviceManager : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int DrainInterval = 20;   ///< Период разбора очередей телеметрии, мс
+
+    DeviceManager(bool isSimulator, bool isNativeTty, QObject *parent = nullptr);
+    ~DeviceManager();
+
+    void setSimulatorDevices(int count) { m_simulatorDevices = qMax(1, count); }
+    void addBus(const QString &portName, const QList<uint8_t> &addresses);
+    static bool parseBus(const QString &spec, QString &portName, QList<uint8_t> &addresses);
+    QList<QPair<QString, QString>> availablePorts() const;
+    static QString nodeName(const QString &portName, int address) { return QString("%1@%2").arg(portName).arg(address); }
+
+    DeviceSession *open(const QString &portName);
+    void close(const QString &portName);
+    void closeAll();
+
+    DeviceSession *session(const QString &portName) const { return m_sessions.value(portName, nullptr); }
+    QList<DeviceSession *> sessions() const { return m_sessions.values(); }
+    int count() const { return m_sessions.size(); }
+
+signals:
+    void opened(DeviceSession *session);
+    void closed(const QString &portName, const QString &error);      ///< Сессия уже не в списке, но ещё не удалена
+    void drained();
+
+private:
+    bool m_isSimulator;
+    bool m_isNativeTty;
+    int m_simulatorDevices = 1;
+
+    std::shared_ptr<spdlog::logger> logger;
+    QTimer m_drainTimer;
+    QMap<QString, DeviceSession *> m_sessions;                          ///< По имени порта, в порядке имён
+    QHash<QString, std::shared_ptr<ParameterCache>> m_caches;           ///< По имени порта, живут между подключениями
+    QMap<QString, QList<uint8_t>> m_buses;                              ///< Адреса узлов по имени порта шины
+    QMap<QString, SerialPortWorker *> m_links;                          ///< Потоки линий шин с открытыми узлами
+
+    void Drain();
+    void SessionError(const QString &portName, const QString &s);
+    SerialPortWorker *Link(const QString &portName);
+    void ReleaseLink(const QString &portName);
+    static bool SplitNode(const QString &name, QString &portName, int &address);
+};
+
+#endif // DEVICEMANAGER_H
@@ -0,0 +1,412 @@
+#include <QFile>
+#include <QJsonDocument>
+#include "deviceparameters.h"
+#include "commanddescriptors.h"
+
+namespace {
+/// Тип переменной PID для параметров регуляторов
+std::optional<PidVariableType> PidType(ParameterSet::Parameter p) {
+    switch (p) {
+        case ParameterSet::CurrentPidP:
+        case ParameterSet::TemperaturePidP:
+            return PidVariableType::Proportional;
+        case ParameterSet::CurrentPidI:
+        case ParameterSet::TemperaturePidI:
+            return PidVariableType::Integral;
+        case ParameterSet::CurrentPidD:
+        case ParameterSet::TemperaturePidD:
+            return PidVariableType::Derivative;
+        case ParameterSet::CurrentPidWindUp:
+        case ParameterSet::TemperaturePidWindUp:
+            return PidVariableType::WindUp;
+        default:
+            return std::nullopt;
+    }
+}
+
+/// Вызвать f(описатель команды параметра)
+template <typename F>
+void WithDescriptor(ParameterSet::Parameter p, F &&f) {
+    switch (p) {
+        case ParameterSet::CurrentPidP:
+        case ParameterSet::CurrentPidI:
+        case ParameterSet::CurrentPidD:
+        case ParameterSet::CurrentPidWindUp:
+            f(tecdesc::CurrentPid{});
+            break;
+        case ParameterSet::TemperaturePidP:
+        case ParameterSet::TemperaturePidI:
+        case ParameterSet::TemperaturePidD:
+        case ParameterSet::TemperaturePidWindUp:
+            f(tecdesc::TemperaturePid{});
+            break;
+        case ParameterSet::TemperatureSetpoint:
+            f(tecdesc::TemperatureSetpoint{});
+            break;
+        case ParameterSet::DebugCurrent:
+            f(tecdesc::DebugCurrent{});
+            break;
+        case ParameterSet::OutputVoltage:
+            f(tecdesc::OutputVoltage{});
+            break;
+        case ParameterSet::Mode:
+            f(tecdesc::Mode{});
+            break;
+        default:
+            break;
+    }
+}
+
+/// Поле значения параметра в данных записи: после типа PID, если он есть
+template <typename D>
+using ValueField = std::tuple_element_t<D::keyed ? 1 : 0, typename D::WriteRequest::Tuple>;
+
+template <typename T>
+T FromDouble(double v) {
+    if constexpr (std::is_enum_v<T>) {
+        return static_cast<T>(static_cast<std::underlying_type_t<T>>(v));
+    } else {
+        return static_cast<T>(v);
+    }
+}
+
+template <typename T>
+double ToDouble(T v) {
+    if constexpr (std::is_enum_v<T>) {
+        return static_cast<double>(qToUnderlying(v));
+    } else {
+        return static_cast<double>(v);
+    }
+}
+
+template <size_t N>
+QByteArray ToByteArray(const std::array<uint8_t, N> &data) {
+    return QByteArray(reinterpret_cast<const char *>(data.data()), data.size());
+}
+
+/// Значения сравниваются так, как они передаются по линии
+bool SameOnWire(ParameterSet::Parameter p, double a, double b) {
+bool same = false;
+    WithDescriptor(p, [&](auto descriptor) {
+        using T = ValueField<decltype(descriptor)>;
+        same = FromDouble<T>(a) == FromDouble<T>(b);
+    });
+    return same;
+}
+}
+
+
+tec::Commands ParameterSet::command(Parameter p) {
+tec::Commands ret = tec::Commands::Invalid;
+    WithDescriptor(p, [&ret](auto descriptor) {
+        ret = decltype(descriptor)::command;
+    });
+    return ret;
+}
+
+/**
+ * @brief Имя параметра в файле профиля
+ */
+const char *ParameterSet::name(Parameter p) {
+static constexpr std::array<const char *, Count> names = {
+        "CurrentPidP", "CurrentPidI", "CurrentPidD", "CurrentPidWindUp",
+        "TemperaturePidP", "TemperaturePidI", "TemperaturePidD", "TemperaturePidWindUp",
+        "TemperatureSetpoint", "DebugCurrent", "OutputVoltage", "WorkMode"
+    };
+    return p < Count ? names[p] : "";
+}
+
+/**
+ * @brief Единицы параметра из описателя команды
+ */
+const char *ParameterSet::unit(Parameter p) {
+const char *ret = "";
+    WithDescriptor(p, [&ret](auto descriptor) {
+        ret = decltype(descriptor)::unit;
+    });
+    return ret;
+}
+
+/**
+ * @brief Данные команды чтения параметра: тип переменной для PID, иначе пусто
+ */
+QByteArray ParameterSet::readPayload(Parameter p) {
+QByteArray arr;
+    WithDescriptor(p, [&](auto descriptor) {
+        using D = decltype(descriptor);
+        if constexpr (D::keyed) {
+            arr = ToByteArray(D::ReadRequest::pack(*PidType(p)));
+        }
+    });
+    return arr;
+}
+
+/**
+ * @brief Данные команды записи параметра, значение должно быть известно
+ */
+QByteArray ParameterSet::writePayload(Parameter p) const {
+QByteArray arr;
+    WithDescriptor(p, [&](auto descriptor) {
+        using D = decltype(descriptor);
+        const auto v = FromDouble<ValueField<D>>(value(p));
+        if constexpr (D::keyed) {
+            arr = ToByteArray(D::WriteRequest::pack(*PidType(p), v));
+        } else {
+            arr = ToByteArray(D::WriteRequest::pack(v));
+        }
+    });
+    return arr;
+}
+
+/**
+ * @brief Разобрать ответ контроллера на чтение параметра
+ * @param[in] command - команда ответа
+ * @param[in] data - данные ответа
+ * @param[out] value - значение параметра
+ * @return параметр, если ответ его содержит
+ */
+std::optional<ParameterSet::Parameter> ParameterSet::fromReply(tec::Commands command, const QByteArray &data, double &value) {
+std::optional<Parameter> ret;
+    tecdesc::Registry::decode(command, tecdesc::bytes(data), [&](auto descriptor, const auto &... fields) {
+        using D = decltype(descriptor);
+        for (int i = 0; i < Count && !ret; i++) {
+            auto p = static_cast<Parameter>(i);
+            WithDescriptor(p, [&](auto parameterDescriptor) {
+                if constexpr (std::is_same_v<decltype(parameterDescriptor), D>) {
+                    const auto reply = std::make_tuple(fields...);
+                    if constexpr (D::keyed) {
+                        if (std::get<0>(reply) == *PidType(p)) {
+                            value = ToDouble(std::get<1>(reply));
+                            ret = p;
+                        }
+                    } else {
+                        value = ToDouble(std::get<0>(reply));
+                        ret = p;
+                    }
+                }
+            });
+        }
+    });
+    return ret;
+}
+
+bool ParameterSet::isEmpty() const {
+    for (const auto &v : m_values) {
+        if (v) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Обновить значение по ответу контроллера
+ * @return false, если ответ не содержит параметра
+ */
+bool ParameterSet::update(tec::Commands command, const QByteArray &data) {
+double v;
+    auto p = fromReply(command, data, v);
+    if (!p) {
+        return false;
+    }
+    m_values[*p] = v;
+    return true;
+}
+
+/**
+ * @brief Параметры, которые надо записать, чтобы привести контроллер к этому набору
+ * @param[in] device - последнее известное состояние контроллера
+ * @return известные здесь параметры, которые в device неизвестны или отличаются
+ */
+QList<ParameterSet::Parameter> ParameterSet::diff(const ParameterSet &device) const {
+QList<Parameter> ret;
+    for (int i = 0; i < Count; i++) {
+        auto p = static_cast<Parameter>(i);
+        if (has(p) && (!device.has(p) || !SameOnWire(p, value(p), device.value(p)))) {
+            ret.append(p);
+        }
+    }
+    return ret;
+}
+
+QJsonObject ParameterSet::toJson() const {
+QJsonObject parameters;
+    for (int i = 0; i < Count; i++) {
+        auto p = static_cast<Parameter>(i);
+        if (has(p)) {
+            parameters.insert(name(p), value(p));
+        }
+    }
+
+QJsonObject json;
+    json.insert("version", ProfileVersion);
+    json.insert("parameters", parameters);
+    return json;
+}
+
+/**
+ * @brief Прочитать набор из JSON профиля, неизвестные и нечисловые ключи пропускаются
+ */
+ParameterSet ParameterSet::fromJson(const QJsonObject &json) {
+ParameterSet ret;
+const auto parameters = json.value("parameters").toObject();
+    for (int i = 0; i < Count; i++) {
+        auto p = static_cast<Parameter>(i);
+        auto v = parameters.value(name(p));
+        if (v.isDouble()) {
+            ret.set(p, v.toDouble());
+        }
+    }
+    return ret;
+}
+
+bool ParameterSet::save(const QString &fileName, QString *error) const {
+QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) {
+            *error = QString("Cannot open %1: %2").arg(fileName).arg(file.errorString());
+        }
+        return false;
+    }
+
+    const auto json = QJsonDocument(toJson()).toJson(QJsonDocument::Indented);
+    if (file.write(json) != json.size()) {
+        if (error) {
+            *error = QString("Cannot write %1: %2").arg(fileName).arg(file.errorString());
+        }
+        return false;
+    }
+    return true;
+}
+
+bool ParameterSet::load(const QString &fileName, QString *error) {
+QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = QString("Cannot open %1: %2").arg(fileName).arg(file.errorString());
+        }
+        return false;
+    }
+
+QJsonParseError parseError;
+const auto doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!doc.isObject()) {
+        if (error) {
+            *error = QString("%1: %2").arg(fileName).arg(parseError.errorString());
+        }
+        return false;
+    }
+
+    const int version = doc.object().value("version").toInt();
+    if (version < 1 || version > ProfileVersion) {
+        if (error) {
+            *error = QString("%1: unsupported profile version %2").arg(fileName).arg(version);
+        }
+        return false;
+    }
+
+    *this = fromJson(doc.object());
+    return true;
+}
+
+
+DeviceParameters::DeviceParameters(QObject *parent) : QObject(parent) {
+    logger = spdlog::get("QPeltierUI");
+}
+
+/**
+ * @brief Сменить поток порта. Известное состояние контроллера сбрасывается
+ */
+void DeviceParameters::setWorker(SerialPortWorker *worker) {
+    m_worker = worker;
+    m_device.clear();
+    m_outstanding = 0;
+    m_failed = 0;
+}
+
+/**
+ * @brief Прочитать все параметры одним пакетом
+ * @return false, если порт не открыт или предыдущий пакет не завершён
+ */
+bool DeviceParameters::readAll() {
+    if (m_worker.isNull() || isBusy()) {
+        return false;
+    }
+
+    logger->info("Read all parameters");
+    m_failed = 0;
+    m_outstanding = ParameterSet::Count;
+    for (int i = 0; i < ParameterSet::Count; i++) {
+        auto p = static_cast<ParameterSet::Parameter>(i);
+        Request(p, ParameterSet::readPayload(p), std::nullopt);
+    }
+    return true;
+}
+
+/**
+ * @brief Записать параметры, отличающиеся от последнего известного состояния контроллера
+ * @param[in] target - требуемые значения, неизвестные параметры не записываются
+ * @return число отправленных команд, -1 - порт не открыт или предыдущий пакет не завершён
+ */
+int DeviceParameters::write(const ParameterSet &target) {
+    if (m_worker.isNull() || isBusy()) {
+        return -1;
+    }
+
+const auto changed = target.diff(m_device);
+    logger->info("Write {} changed parameters", changed.size());
+    if (changed.isEmpty()) {
+        emit finished(true, 0);
+        return 0;
+    }
+
+    m_failed = 0;
+    m_outstanding = static_cast<int>(changed.size());
+    for (auto p : changed) {
+        Request(p, target.writePayload(p), target.value(p));
+    }
+    return static_cast<int>(changed.size());
+}
+
+void DeviceParameters::Request(ParameterSet::Parameter p, const QByteArray &payload, std::optional<double> written) {
+const auto cmd = ParameterSet::command(p);
+SerialPortWorker *worker = m_worker.data();
+    worker->request(cmd, payload, [this, worker, p, cmd, written](SerialPortWorker::CommandError error, const QByteArray &data) {
+        if (worker != m_worker.data()) {
+            return;     // Ответ от предыдущего подключения
+        }
+
+        if (error != SerialPortWorker::CommandError::NoError) {
+            logger->warn("Parameter {}: {}", ParameterSet::name(p), error == SerialPortWorker::CommandError::TimeoutError ? "timeout" : "error");
+            m_device.reset(p);
+            Done(false);
+            return;
+        }
+
+        // Ответ на запись может не содержать значения, тогда принято записанное
+        double v;
+        auto replied = ParameterSet::fromReply(cmd, data, v);
+        if (replied && *replied == p) {
+            m_device.set(p, v);
+        } else if (written) {
+            m_device.set(p, *written);
+        } else {
+            logger->warn("Parameter {}: unexpected reply size {}", ParameterSet::name(p), data.size());
+            Done(false);
+            return;
+        }
+        logger->debug("Parameter {} = {} {}", ParameterSet::name(p), m_device.value(p), ParameterSet::unit(p));
+        emit parameterChanged(p, m_device.value(p));
+        Done(true);
+    }, this);
+}
+
+void DeviceParameters::Done(bool ok) {
+    if (!ok) {
+        m_failed++;
+    }
+    if (m_outstanding > 0 && --m_outstanding == 0) {
+        logger->info("Parameters batch finished, failed {}", m_failed);
+        emit finished(m_failed == 0, m_failed);
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef DEVICEPARAMETERS_H
+#define DEVICEPARAMETERS_H
+
+#include <array>
+#include <optional>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include "spdlog/spdlog.h"
+#include "serialportworker.h"
+#include <proto.hpp>
+#include <commands.hpp>
+
+/**
+ * @brief Набор настраиваемых параметров контроллера (профиль)
+ *
+ * Значение параметра может быть неизвестно: профиль может быть неполным, а состояние контроллера - ещё не прочитано.
+ */
+class ParameterSet {
+public:
+    enum Parameter {
+        CurrentPidP,
+        CurrentPidI,
+        CurrentPidD,
+        CurrentPidWindUp,
+        TemperaturePidP,
+        TemperaturePidI,
+        TemperaturePidD,
+        TemperaturePidWindUp,
+        TemperatureSetpoint,
+        DebugCurrent,
+        OutputVoltage,
+        Mode,
+        Count
+    };
+
+    static tec::Commands command(Parameter p);
+    static const char *name(Parameter p);
+    static const char *unit(Parameter p);
+    static QByteArray readPayload(Parameter p);
+    QByteArray writePayload(Parameter p) const;
+    static std::optional<Parameter> fromReply(tec::Commands command, const QByteArray &data, double &value);
+
+    bool has(Parameter p) const { return m_values[p].has_value(); }
+    double value(Parameter p) const { return m_values[p].value_or(0.0); }
+    void set(Parameter p, double value) { m_values[p] = value; }
+    void reset(Parameter p) { m_values[p].reset(); }
+    void clear() { m_values.fill(std::nullopt); }
+    bool isEmpty() const;
+
+    bool update(tec::Commands command, const QByteArray &data);
+    QList<Parameter> diff(const ParameterSet &device) const;
+
+    QJsonObject toJson() const;
+    static ParameterSet fromJson(const QJsonObject &json);
+    bool save(const QString &fileName, QString *error = nullptr) const;
+    bool load(const QString &fileName, QString *error = nullptr);
+
+private:
+    std::array<std::optional<double>, Count> m_values;
+
+    static constexpr int ProfileVersion = 1;
+};
+
+/**
+ * @brief Пакетное чтение и запись параметров контроллера
+ *
+ * Все запросы пакета ставятся в очередь команд SerialPortWorker разом и уходят конвейером. Последнее известное
+ * состояние контроллера (device()) обновляется по ответам, запись отправляет только отличия от него.
+ */
+class DeviceParameters : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DeviceParameters(QObject *parent = nullptr);
+
+    void setWorker(SerialPortWorker *worker);
+    const ParameterSet &device() const { return m_device; }
+    bool isBusy() const { return m_outstanding > 0; }
+
+    bool readAll();
+    int write(const ParameterSet &target);
+
+signals:
+    void parameterChanged(ParameterSet::Parameter p, double value);
+    void finished(bool ok, int failed);
+
+private:
+    QPointer<SerialPortWorker> m_worker;
+    ParameterSet m_device;
+    int m_outstanding = 0;
+    int m_failed = 0;
+
+    std::shared_ptr<spdlog::logger> logger;
+
+    void Request(ParameterSet::Parameter p, const QByteArray &payload, std::optional<double> written);
+    void Done(bool ok);
+};
+
+#endif // DEVICEPARAMETERS_H
@@ -0,0 +1,133 @@
+#include <numeric>
+#include <QDateTime>
+#include "devicesession.h"
+
+
+DeviceSession::DeviceSession(const QString &portName, bool isSimulator, bool isNativeTty, std::shared_ptr<ParameterCache> cache,
+                             SerialPortWorker *link, int address, QObject *parent)
+    : m_portName(portName), m_cache(std::move(cache)), m_link(link), m_address(address), QObject(parent) {
+    logger = spdlog::get("Serial");
+    m_clock.start();
+
+    m_worker = new SerialPortWorker(isSimulator);
+    if (isNativeTty) {
+        m_worker->setTransport(SerialPortWorker::Transport::NativeTty);
+    }
+    m_worker->setParameterCache(m_cache);
+
+    connect(m_worker, &SerialPortWorker::error, this, [this](const QString &s) {
+        emit error(m_portName, s);
+    }, static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::SingleShotConnection));
+
+    // Версия нужна заголовку записи. Ответ ловится и на запросы из интерфейса
+    connect(m_worker, &SerialPortWorker::commandExecute, this, [this](SerialPortWorker::CommandError error, tec::Commands command, const QByteArray &data) {
+        if (error != SerialPortWorker::CommandError::NoError || command != tecdesc::Version::command) {
+            return;
+        }
+        if (auto version = tecdesc::Version::decode(tecdesc::bytes(data))) {
+            std::tie(m_hardwareVersion, m_firmwareVersion) = *version;
+        }
+    }, Qt::QueuedConnection);
+}
+
+DeviceSession::~DeviceSession() {
+    stopRecording();
+    delete m_worker;
+}
+
+/**
+ * @brief Запустить поток порта (или подключиться к линии шины) и запросить версию контроллера
+ * @param[in] waitTimeout - таймаут ожидания данных потоком порта, мс
+ */
+void DeviceSession::start(int waitTimeout) {
+    logger->info("Open {}", m_portName.toStdString());
+    if (m_link) {
+        m_worker->attachToBus(m_link, m_address);
+    } else {
+        m_worker->startReceiver(m_portName, waitTimeout);
+    }
+    m_worker->getVersion();
+}
+
+/**
+ * @brief Забрать накопленную телеметрию из очереди потока порта. Вызывается из потока GUI
+ * @return Разобрано кадров
+ */
+size_t DeviceSession::drain() {
+auto count = m_worker->telemetryQueue().drain([this](const TelemetryRecord &record) {
+        Telemetry(record);
+    });
+
+const auto now = m_clock.elapsed();
+    if (count > 0) {
+        m_summary.lastFrame = now;
+        m_rateFrames += count;
+    }
+    if (now - m_rateStart >= RateWindow) {
+        m_summary.framesPerSecond = m_rateFrames * 1000.0 / (now - m_rateStart);
+        m_rateStart = now;
+        m_rateFrames = 0;
+    }
+    return count;
+}
+
+void DeviceSession::Telemetry(const TelemetryRecord &record) {
+const auto &frame = record.frame;
+    m_summary.frames++;
+    m_summary.temperature = frame.temperature;
+    m_summary.current = std::accumulate(frame.current.begin(), frame.current.end(), 0) / 1000.0 / frame.current.size();
+
+    if (m_recorder) {
+        m_recorder->append(record);
+        m_recordSamples += (record.lost + 1) * static_cast<qint64>(frame.current.size());
+    }
+    if (m_sink) {
+        m_sink(record);
+    }
+}
+
+/**
+ * @brief Начать запись телеметрии в файл. Идущая запись останавливается
+ * @param[in] fileName - имя файла
+ * @param[in] timebase - период отсчёта тока, секунд
+ */
+bool DeviceSession::startRecording(const QString &fileName, double timebase) {
+    stopRecording();
+
+TelemetryRecorder::Info info;
+    info.timebase = timebase;
+    info.hardwareVersion = m_hardwareVersion;
+    info.firmwareVersion = m_firmwareVersion;
+    m_recorder = new TelemetryRecorder(fileName);
+    connect(m_recorder, &TelemetryRecorder::error, this, [this](const QString &s) {
+        logger->error("{}: {}", m_portName.toStdString(), s.toStdString());
+        stopRecording();
+    }, static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::SingleShotConnection));
+
+    if (!m_recorder->open(info)) {
+        delete m_recorder;
+        m_recorder = nullptr;
+        return false;
+    }
+    m_recordSamples = 0;
+    m_recordTimebase = timebase;
+    return true;
+}
+
+void DeviceSession::stopRecording() {
+    delete m_recorder;
+    m_recorder = nullptr;
+}
+
+/**
+ * @brief Имя файла записи для устройства: Record-<порт>-<дата>.qpr
+ */
+QString DeviceSession::recordFileName(const QString &portName) {
+QString port = portName;
+    for (auto &c : port) {
+        if (!c.isLetterOrNumber()) {
+            c = '_';
+        }
+    }
+    return QString("Record-%1-%2.qpr").arg(port).arg(QDateTime::currentDateTime().toString("dd.MM.yy-hh_mm_ss_zzz"));
+}
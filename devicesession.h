@@ -0,0 +1,92 @@
+#ifndef DEVICESESSION_H
+#define DEVICESESSION_H
+
+#include <functional>
+#include <limits>
+#include <memory>
+#include <QElapsedTimer>
+#include <QObject>
+#include "spdlog/spdlog.h"
+#include "serialportworker.h"
+#include "parametercache.h"
+#include "telemetryrecorder.h"
+
+/**
+ * @brief Подключение к одному контроллеру: поток порта, кэш параметров, запись и сводка телеметрии
+ *
+ * У каждого контроллера свой SerialPortWorker (свой поток приёма и своя очередь телеметрии), поэтому
+ * устройства не влияют друг на друга. Очередь телеметрии разбирает drain() в потоке GUI: кадры уходят
+ * в запись, в сводку для общей панели и, если задан, в приёмник подробного вида (графики MainWindow).
+ * Контроллер на шине RS-485 работает через поток линии link со своим адресом, своими очередью команд и телеметрией.
+ */
+class DeviceSession : public QObject {
+    Q_OBJECT
+
+public:
+    /// Последние значения телеметрии для общей панели
+    struct Summary {
+        double temperature = std::numeric_limits<double>::quiet_NaN();  ///< °C
+        double current = std::numeric_limits<double>::quiet_NaN();      ///< Средний ток последнего кадра, А
+        uint64_t frames = 0;                ///< Разобрано кадров за сессию
+        double framesPerSecond = 0;         ///< За последнюю секунду
+        qint64 lastFrame = -1;              ///< Время последнего кадра, мс от открытия сессии
+    };
+
+    using Sink = std::function<void(const TelemetryRecord &record)>;
+
+    DeviceSession(const QString &portName, bool isSimulator, bool isNativeTty, std::shared_ptr<ParameterCache> cache,
+                  SerialPortWorker *link = nullptr, int address = Wake::NoAddress, QObject *parent = nullptr);
+    ~DeviceSession();
+
+    const QString &portName() const { return m_portName; }
+    SerialPortWorker *worker() const { return m_worker; }
+    const std::shared_ptr<ParameterCache> &cache() const { return m_cache; }
+
+    void start(int waitTimeout = 10);
+
+    void setSink(Sink sink) { m_sink = std::move(sink); }
+    size_t drain();
+    const Summary &summary() const { return m_summary; }
+    qint64 sinceLastFrame() const { return m_summary.lastFrame < 0 ? -1 : m_clock.elapsed() - m_summary.lastFrame; }
+
+    uint32_t hardwareVersion() const { return m_hardwareVersion; }
+    uint32_t firmwareVersion() const { return m_firmwareVersion; }
+
+    bool startRecording(const QString &fileName, double timebase = 500e-6);
+    void stopRecording();
+    bool isRecording() const { return m_recorder != nullptr; }
+    QString recordFileName() const { return m_recorder ? m_recorder->fileName() : QString(); }
+    double recordedTime() const { return m_recordSamples * m_recordTimebase; }
+
+    static QString recordFileName(const QString &portName);
+
+signals:
+    void error(const QString &portName, const QString &s);
+
+private:
+    static constexpr qint64 RateWindow = 1000;     ///< Окно расчёта кадров в секунду, мс
+
+    std::shared_ptr<spdlog::logger> logger;
+    QString m_portName;
+    SerialPortWorker *m_worker;
+    SerialPortWorker *m_link;               ///< Линия шины RS-485, nullptr - свой порт
+    int m_address;
+    std::shared_ptr<ParameterCache> m_cache;
+    Sink m_sink;
+
+    Summary m_summary;
+    QElapsedTimer m_clock;
+    qint64 m_rateStart = 0;
+    uint64_t m_rateFrames = 0;
+
+    uint32_t m_hardwareVersion = 0;
+    uint32_t m_firmwareVersion = 0;
+
+    TelemetryRecorder *m_recorder = nullptr;
+    qint64 m_recordSamples = 0;
+    double m_recordTimebase = 500e-6;
+
+    void Telemetry(const TelemetryRecord &record);
+};
+
+#endif // DEVICESESSION_H
@@ -0,0 +1,118 @@
+#ifndef FRAMECOUNTER_H
+#define FRAMECOUNTER_H
+
+#include <cstdint>
+
+/**
+ * @brief Контроль порядкового номера кадров телеметрии (uint16_t с переполнением)
+ *
+ * Номер вперёд от ожидаемого не дальше MaxGap - потеря (delta - 1 кадров). Номер позади в пределах последних
+ * HistorySize кадров - повтор, если такой кадр уже был, иначе опоздавший кадр, ранее учтённый как потерянный.
+ * Номер дальше вперёд или позади - перезапуск счётчика контроллером или испорченный номер, прошедший CRC:
+ * отсчёт начинается заново, без заполнения пропуска. Кадр старше первого кадра или точки перезапуска -
+ * повтор: потерянным он не учитывался.
+ */
+class FrameCounterTracker {
+public:
+    enum class Result {
+        First,          ///< Первый кадр после reset()
+        InOrder,
+        Gap,            ///< Перед кадром потеряно lost() кадров
+        Duplicate,      ///< Повтор уже принятого кадра
+        Reordered,      ///< Опоздавший кадр, уже учтённый как потерянный
+        Restart         ///< Счётчик перезапущен
+    };
+
+    struct Stats {
+        uint64_t received = 0;      ///< Принято кадров (без повторов)
+        uint64_t lost = 0;          ///< Потеряно кадров (за вычетом опоздавших)
+        uint64_t duplicates = 0;
+        uint64_t reordered = 0;
+        uint64_t restarts = 0;
+        uint64_t gaps = 0;          ///< Число пропусков (серий потерь)
+        uint64_t maxBurst = 0;      ///< Самая длинная серия потерь, кадров
+
+        double lossRate() const { return received + lost ? static_cast<double>(lost) / (received + lost) : 0.0; }
+        double meanBurst() const { return gaps ? static_cast<double>(lost + reordered) / gaps : 0.0; }
+    };
+
+    static constexpr uint16_t MaxGap = 1024;   ///< Наибольший учитываемый пропуск, кадров (~20 с при кадре 20 мс)
+
+    void reset() {
+        m_started = false;
+        m_stats = Stats();
+    }
+
+    Result update(uint16_t counter) {
+        m_lost = 0;
+        if (!m_started) {
+            Restart(counter);
+            m_stats.received++;
+            return Result::First;
+        }
+
+        const uint16_t delta = static_cast<uint16_t>(counter - m_expected);
+        if (delta == 0) {
+            Accept(counter, 1);
+            return Result::InOrder;
+        }
+
+        if (delta <= MaxGap) {
+            m_lost = delta;
+            m_stats.lost += delta;
+            m_stats.gaps++;
+            if (delta > m_stats.maxBurst) {
+                m_stats.maxBurst = delta;
+            }
+            Accept(counter, delta + 1);
+            return Result::Gap;
+        }
+
+        const uint16_t back = static_cast<uint16_t>(m_expected - counter);     // 1 - последний принятый
+        if (back <= HistorySize) {
+            const uint64_t bit = uint64_t(1) << (back - 1);
+            if (m_received & bit) {
+                m_stats.duplicates++;
+                return Result::Duplicate;
+            }
+            m_received |= bit;
+            m_stats.lost--;
+            m_stats.reordered++;
+            m_stats.received++;
+            return Result::Reordered;
+        }
+
+        m_stats.restarts++;
+        Restart(counter);
+        m_stats.received++;
+        return Result::Restart;
+    }
+
+    /// Потеряно кадров перед последним кадром с результатом Gap
+    uint16_t lost() const { return m_lost; }
+    const Stats &stats() const { return m_stats; }
+
+private:
+    static constexpr uint16_t HistorySize = 64;
+
+    bool m_started = false;
+    uint16_t m_expected = 0;
+    uint64_t m_received = 0;    ///< Бит k - принят кадр m_expected - 1 - k
+    uint16_t m_lost = 0;
+    Stats m_stats;
+
+    /// Кадры до точки перезапуска потерянными не учитывались - история помечает их принятыми
+    void Restart(uint16_t counter) {
+        m_started = true;
+        m_expected = static_cast<uint16_t>(counter + 1);
+        m_received = ~uint64_t(0);
+    }
+
+    void Accept(uint16_t counter, uint16_t shift) {
+        m_received = shift < HistorySize ? (m_received << shift) | 1 : 1;
+        m_expected = static_cast<uint16_t>(counter + 1);
+        m_stats.received++;
+    }
+};
+
+#endif // FRAMECOUNTER_H
@@ -0,0 +1,246 @@
+#include <QVector2D>
+#include "gltracewidget.h"
+#include "spdlog/spdlog.h"
+
+static const char *VertexShader = R"(
+#version 330 core
+layout(location = 0) in float y;
+uniform float u_offset;     // Положение вершины в окне = gl_VertexID + u_offset
+uniform float u_window;     // Ширина окна - 1, отсчётов
+uniform vec2 u_range;       // Диапазон Y
+void main() {
+    float x = (float(gl_VertexID) + u_offset) / u_window * 2.0 - 1.0;
+    float v = (y - u_range.x) / (u_range.y - u_range.x) * 2.0 - 1.0;
+    gl_Position = vec4(x, v, 0.0, 1.0);
+}
+)";
+
+static const char *FragmentShader = R"(
+#version 330 core
+uniform vec4 u_color;
+out vec4 color;
+void main() {
+    color = u_color;
+}
+)";
+
+
+GlTraceWidget::GlTraceWidget(QWidget *parent) : QOpenGLWidget(parent), m_vbo(QOpenGLBuffer::VertexBuffer) {
+    setFormat(surfaceFormat());
+    m_extrema.reset(m_window);
+}
+
+GlTraceWidget::~GlTraceWidget() {
+    makeCurrent();
+    m_vbo.destroy();
+    m_vao.destroy();
+    doneCurrent();
+}
+
+QSurfaceFormat GlTraceWidget::surfaceFormat() {
+QSurfaceFormat format;
+
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    return format;
+}
+
+void GlTraceWidget::append(const double *data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        m_pending.push_back(static_cast<float>(data[i]));
+    }
+    m_total += count;
+    m_extrema.append(data, count);
+    if (count > 0) {
+        m_last = data[count - 1];
+    }
+
+    // Пока виджет скрыт, кадры не рисуются: больше окна копить незачем
+    if (m_pending.size() > 2 * m_window) {
+        m_pending.erase(m_pending.begin(), m_pending.end() - m_window);
+        m_gpuFirst = m_total - m_window;
+    }
+    m_dirty = true;
+}
+
+void GlTraceWidget::addGap(size_t samples) {
+    if (samples == 0) {
+        return;
+    }
+
+    const uint64_t begin = m_total;
+    m_hold.assign(samples, m_last);
+    append(m_hold.data(), m_hold.size());
+
+    while (!m_gaps.empty() && m_gaps.front().end + m_window <= m_total) {
+        m_gaps.pop_front();
+    }
+    m_gaps.push_back(Gap{begin, m_total});
+}
+
+void GlTraceWidget::clear() {
+    m_pending.clear();
+    m_total = 0;
+    m_gpuFirst = 0;
+    m_extrema.clear();
+    m_gaps.clear();
+    m_reallocate = true;
+    m_dirty = true;
+}
+
+void GlTraceWidget::setWindow(size_t samples) {
+    m_window = std::max<size_t>(samples, 2);
+    m_extrema.reset(m_window);
+    m_pending.clear();
+    m_total = 0;
+    m_gpuFirst = 0;
+    m_gaps.clear();
+    m_reallocate = true;
+    m_dirty = true;
+}
+
+void GlTraceWidget::setRange(double lo, double hi) {
+    m_lo = lo;
+    m_hi = hi;
+    m_dirty = true;
+}
+
+bool GlTraceWidget::render() {
+    if (!m_dirty) {
+        return false;
+    }
+
+    m_dirty = false;
+    update();
+    return true;
+}
+
+void GlTraceWidget::initializeGL() {
+    initializeOpenGLFunctions();
+
+    if (!m_program.addShaderFromSourceCode(QOpenGLShader::Vertex, VertexShader) ||
+        !m_program.addShaderFromSourceCode(QOpenGLShader::Fragment, FragmentShader) ||
+        !m_program.link()) {
+        spdlog::get("QPeltierUI")->error("Trace shader: {}", m_program.log().toStdString());
+        return;
+    }
+
+    m_vao.create();
+    m_vao.bind();
+    m_vbo.create();
+    m_vbo.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    m_vbo.bind();
+    m_vbo.allocate(static_cast<int>((m_window + 1) * sizeof(float)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 1, GL_FLOAT, GL_FALSE, 0, nullptr);
+    m_vao.release();
+    m_reallocate = false;
+    m_gpuFirst = m_total - m_pending.size();
+}
+
+/**
+ * @brief Дописать в кольцо на GPU отсчёты, поступившие после прошлого кадра
+ */
+void GlTraceWidget::Upload() {
+const float *data = m_pending.data();
+size_t count = m_pending.size();
+uint64_t index = m_total - count;
+
+    m_vbo.bind();
+    if (m_reallocate) {
+        m_vbo.allocate(static_cast<int>((m_window + 1) * sizeof(float)));
+        m_reallocate = false;
+        m_gpuFirst = index;
+    }
+
+    if (count > m_window) {
+        data += count - m_window;
+        index += count - m_window;
+        count = m_window;
+    }
+
+    while (count > 0) {
+        const size_t pos = static_cast<size_t>(index % m_window);
+        const size_t len = std::min(count, m_window - pos);
+        m_vbo.write(static_cast<int>(pos * sizeof(float)), data, static_cast<int>(len * sizeof(float)));
+        if (pos == 0) {
+            // Копия нулевого элемента за концом кольца соединяет его части
+            m_vbo.write(static_cast<int>(m_window * sizeof(float)), data, sizeof(float));
+        }
+        data += len;
+        index += len;
+        count -= len;
+    }
+    m_pending.clear();
+}
+
+void GlTraceWidget::paintGL() {
+const QColor background = palette().color(QPalette::Base);
+const QColor line = palette().color(QPalette::Highlight);
+
+    glClearColor(background.redF(), background.greenF(), background.blueF(), 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (!m_program.isLinked()) {
+        return;
+    }
+
+    m_vao.bind();
+    Upload();
+
+    const uint64_t first = std::max(m_gpuFirst, m_total > m_window ? m_total - m_window : 0);
+    const size_t count = static_cast<size_t>(m_total - first);
+    if (count < 2) {
+        m_vao.release();
+        return;
+    }
+
+    double lo = m_lo;
+    double hi = m_hi;
+    if (lo >= hi) {
+        lo = m_extrema.min(first);
+        hi = m_extrema.max(first);
+        const double margin = std::max((hi - lo) * 0.05, 1e-6);
+        lo -= margin;
+        hi += margin;
+    }
+
+    m_program.bind();
+    m_program.setUniformValue("u_window", static_cast<float>(m_window - 1));
+    m_program.setUniformValue("u_range", QVector2D(static_cast<float>(lo), static_cast<float>(hi)));
+    m_program.setUniformValue("u_color", line);
+
+    // Самый старый отсчёт окна - в позиции base, новый - у правого края. Отсчёты пропусков не рисуются
+    const size_t base = m_window - count;
+    uint64_t from = first;
+    for (const auto &gap : m_gaps) {
+        if (gap.begin > from) {
+            DrawStrip(from, gap.begin, first, base);
+        }
+        from = std::max(from, gap.end);
+    }
+    if (from < m_total) {
+        DrawStrip(from, m_total, first, base);
+    }
+
+    m_program.release();
+    m_vao.release();
+}
+
+/**
+ * @brief Нарисовать отсчёты [begin, end) одной ломаной
+ * @param first Номер самого старого отсчёта окна
+ * @param base Положение отсчёта first в окне
+ */
+void GlTraceWidget::DrawStrip(uint64_t begin, uint64_t end, uint64_t first, size_t base) {
+const size_t count = static_cast<size_t>(end - begin);
+const size_t p0 = static_cast<size_t>(begin % m_window);
+const size_t n1 = std::min(count, m_window - p0);
+const size_t x0 = base + static_cast<size_t>(begin - first);
+
+    m_program.setUniformValue("u_offset", static_cast<float>(x0) - static_cast<float>(p0));
+    glDrawArrays(GL_LINE_STRIP, static_cast<GLint>(p0), static_cast<GLsizei>(n1 + (count > n1 ? 1 : 0)));
+    if (count > n1) {
+        m_program.setUniformValue("u_offset", static_cast<float>(x0 + n1));
+        glDrawArrays(GL_LINE_STRIP, 0, static_cast<GLsizei>(count - n1));
+    }
+}
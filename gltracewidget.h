@@ -0,0 +1,71 @@
+#ifndef GLTRACEWIDGET_H
+#define GLTRACEWIDGET_H
+
+#include <QOpenGLBuffer>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QOpenGLWidget>
+#include <deque>
+#include <vector>
+#include "slidingminmax.h"
+#include "streamingtrace.h"
+
+/**
+ * @brief График потока на OpenGL 3.3
+ *
+ * Отсчёты лежат в кольцевом буфере вершин на GPU (только Y, float), ёмкость - окно плюс копия нулевого элемента
+ * в конце, чтобы две части кольца рисовались без разрыва. За кадр в буфер дописываются только отсчёты,
+ * поступившие после прошлого кадра. X вычисляет вершинный шейдер по gl_VertexID и сдвигу кольца.
+ * Пропуск заполняется последним значением, а ломаная рисуется отдельными участками между пропусками.
+ */
+class GlTraceWidget : public QOpenGLWidget, public StreamingTrace, protected QOpenGLExtraFunctions {
+    Q_OBJECT
+
+public:
+    explicit GlTraceWidget(QWidget *parent = nullptr);
+    ~GlTraceWidget();
+
+    static QSurfaceFormat surfaceFormat();
+
+    QWidget *widget() override { return this; }
+    void append(const double *data, size_t count) override;
+    void addGap(size_t samples) override;
+    void clear() override;
+    void setWindow(size_t samples) override;
+    void setRange(double lo, double hi) override;
+    bool render() override;
+
+protected:
+    void initializeGL() override;
+    void paintGL() override;
+
+private:
+    QOpenGLShaderProgram m_program;
+    QOpenGLBuffer m_vbo;
+    QOpenGLVertexArrayObject m_vao;
+
+    size_t m_window = 20001;        ///< Ёмкость кольца, отсчётов
+    bool m_reallocate = true;       ///< Буфер вершин нужно пересоздать (новое окно или очистка)
+    std::vector<float> m_pending;   ///< Отсчёты, ещё не переданные на GPU
+    uint64_t m_total = 0;           ///< Всего отсчётов
+    uint64_t m_gpuFirst = 0;        ///< Номер первого отсчёта, непрерывно лежащего в кольце на GPU
+    bool m_dirty = false;
+
+    struct Gap {
+        uint64_t begin;
+        uint64_t end;
+    };
+    std::deque<Gap> m_gaps;         ///< Пропуски в окне, номера отсчётов [begin, end)
+    std::vector<double> m_hold;
+    double m_last = 0;              ///< Последний отсчёт, им заполняется пропуск
+
+    SlidingMinMax m_extrema;
+    double m_lo = 0;
+    double m_hi = 0;
+
+    void Upload();
+    void DrawStrip(uint64_t begin, uint64_t end, uint64_t first, size_t base);
+};
+
+#endif // GLTRACEWIDGET_H
@@ -0,0 +1,55 @@
+#ifdef __WIN32__
+#include <spdlog/sinks/wincolor_sink.h>
+#include <spdlog/sinks/msvc_sink.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/sinks/rotating_file_sink.h>
+#else
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/sinks/rotating_file_sink.h>
+#endif
+
+#include <vector>
+#include "logging.h"
+
+namespace logging {
+
+static std::vector<spdlog::sink_ptr> sinks;
+static spdlog::level::level_enum sinksLevel = spdlog::level::debug;
+
+/**
+ * @brief Создать приёмники и зарегистрировать логгеры IO, Serial, Wake и QPeltierUI
+ * @param[in] fileName - файл журнала, ротация по 50 МБ, 10 файлов
+ * @param[in] level - уровень всех логгеров
+ */
+void init(const spdlog::filename_t &fileName, spdlog::level::level_enum level) {
+    sinks.clear();
+    sinksLevel = level;
+#ifdef __WIN32__
+    sinks.push_back(std::make_shared<spdlog::sinks::wincolor_stdout_sink_mt>());
+    sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
+    sinks.push_back(std::make_shared<spdlog::sinks::msvc_sink_mt>());
+#else
+    sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
+#endif
+    sinks.push_back(std::make_shared<spdlog::sinks::rotating_file_sink_mt>(fileName, 1024*1024*50, 10, true));
+
+    for (const auto name : {"IO", "Serial", "Wake", "QPeltierUI"}) {
+        create(name);
+    }
+}
+
+/**
+ * @brief Логгер с общими приёмниками. Вызывать после init()
+ */
+std::shared_ptr<spdlog::logger> create(const std::string &name) {
+    if (auto logger = spdlog::get(name)) {
+        return logger;
+    }
+
+auto logger = std::make_shared<spdlog::logger>(name, sinks.begin(), sinks.end());
+    logger->set_level(sinksLevel);
+    spdlog::register_logger(logger);
+    return logger;
+}
+
+}
@@ -0,0 +1,21 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <memory>
+#include <string>
+#include "spdlog/spdlog.h"
+
+/**
+ * @brief Журнал приложения: общие приёмники (консоль, файл с ротацией) и именованные логгеры
+ *
+ * Вызывается один раз из main() до создания окон и потоков: потоки порта, Wake и запись берут
+ * логгеры IO, Serial, Wake и QPeltierUI по имени.
+ */
+namespace logging {
+
+void init(const spdlog::filename_t &fileName, spdlog::level::level_enum level = spdlog::level::debug);
+std::shared_ptr<spdlog::logger> create(const std::string &name);
+
+}
+
+#endif // LOGGING_H
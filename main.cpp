@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "logging.h"
 
 #include <QApplication>
 #include <QDir>
@@ -17,6 +18,7 @@ QApplication a(argc, argv);
             return 1;
         }
     }
+    logging::init(SPDLOG_FILENAME_T("logs/QPeltierUI.log"));
 
     QCoreApplication::setOrganizationName("MeshLab");
     QCoreApplication::setApplicationName("QPeltierUI");
@@ -26,8 +28,21 @@ QCommandLineParser parser;
     parser.addHelpOption();
 QCommandLineOption simulatorOption(QStringList() << "s" << "simulator" << "Enable simulator mode");
     parser.addOption(simulatorOption);
+QCommandLineOption nativeTtyOption(QStringList() << "native-tty", "Use termios/epoll serial transport (Linux only)");
+    parser.addOption(nativeTtyOption);
+QCommandLineOption simulatorDevicesOption(QStringList() << "simulator-devices", "Number of simulated controllers", "count", "1");
+    parser.addOption(simulatorDevicesOption);
+QCommandLineOption busOption(QStringList() << "bus", "RS-485 bus with addressed controllers, e.g. ttyUSB0:1,2,3. May be repeated", "port:addresses");
+    parser.addOption(busOption);
+QCommandLineOption fpsOption(QStringList() << "fps", "Chart refresh rate cap, 0 - screen refresh rate", "fps", "0");
+    parser.addOption(fpsOption);
+QCommandLineOption glTraceOption(QStringList() << "gl-trace", "Draw current as a streaming OpenGL trace (software fallback without OpenGL 3.3)");
+    parser.addOption(glTraceOption);
+QCommandLineOption softwareTraceOption(QStringList() << "software-trace", "Draw current as a streaming trace with QPainter");
+    parser.addOption(softwareTraceOption);
     parser.process(a);
     bool isSimulator = parser.isSet(simulatorOption);
+    bool isNativeTty = parser.isSet(nativeTtyOption);
 
 QPalette palette;
     a.setStyle(QStyleFactory::create("fusion"));
@@ -52,7 +67,20 @@ QPalette palette;
 
     a.setPalette(palette);
 
-MainWindow w(isSimulator);
+MainWindow w(isSimulator, isNativeTty, parser.value(simulatorDevicesOption).toInt());
+    for (const auto &bus : parser.values(busOption)) {
+        QString portName;
+        QList<uint8_t> addresses;
+        if (!DeviceManager::parseBus(bus, portName, addresses)) {
+            QMessageBox::critical(nullptr, "Bus error", QString("Invalid bus '%1', expected port:address[,address...]").arg(bus));
+            return 1;
+        }
+        w.addBus(portName, addresses);
+    }
+    w.setFpsCap(parser.value(fpsOption).toDouble());
+    if (parser.isSet(glTraceOption) || parser.isSet(softwareTraceOption)) {
+        w.useStreamingTrace(!parser.isSet(softwareTraceOption));
+    }
     w.show();
     auto exit_code = a.exec();
     spdlog::shutdown();
@@ -1,51 +1,20 @@
 
-#ifdef __WIN32__
-#include <spdlog/sinks/wincolor_sink.h>
-#include <spdlog/sinks/msvc_sink.h>
-#include <spdlog/sinks/stdout_color_sinks.h>
-#include <spdlog/sinks/rotating_file_sink.h>
-#else
-#include <spdlog/sinks/stdout_color_sinks.h>
-#endif
-
+#include <cmath>
 #include <QDateTime>
+#include <QFileDialog>
+#include <QScreen>
 #include <QStringBuilder>
 #include <QTimer>
 #include <QSerialPortInfo>
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "gltracewidget.h"
 #include <proto.hpp>
 
-MainWindow::MainWindow(bool isSimulator, QWidget *parent) : isSimulator(isSimulator), QMainWindow(parent), ui(new Ui::MainWindow) {
+MainWindow::MainWindow(bool isSimulator, bool isNativeTty, int simulatorDevices, QWidget *parent) : isSimulator(isSimulator), isNativeTty(isNativeTty), QMainWindow(parent), ui(new Ui::MainWindow) {
     ui->setupUi(this);
     
-    std::vector<spdlog::sink_ptr> sinks;
-#ifdef __WIN32__
-    sinks.push_back(std::make_shared<spdlog::sinks::wincolor_stdout_sink_mt>());
-    sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
-    sinks.push_back(std::make_shared<spdlog::sinks::msvc_sink_mt>());
-    sinks.push_back(std::make_shared<spdlog::sinks::rotating_file_sink_mt>(L"logs/QPeltierUI.log", 1024*1024*50, 10, true));
-#else
-    sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
-    sinks.push_back(std::make_shared<spdlog::sinks::rotating_file_sink_mt>("logs/QPeltierUI.log", 1024*1024*50, 10, true));
-#endif
-    
-    logger = std::make_shared<spdlog::logger>("IO", sinks.begin(), sinks.end());
-    logger->set_level(spdlog::level::debug);
-    spdlog::register_logger(logger);
-
-    logger = std::make_shared<spdlog::logger>("Serial", sinks.begin(), sinks.end());
-    logger->set_level(spdlog::level::debug);
-    spdlog::register_logger(logger);
-    
-    logger = std::make_shared<spdlog::logger>("Wake", sinks.begin(), sinks.end());
-    logger->set_level(spdlog::level::debug);
-    spdlog::register_logger(logger);
-    
-    logger = std::make_shared<spdlog::logger>("QPeltierUI", sinks.begin(), sinks.end());
-    logger->set_level(spdlog::level::debug);
-    spdlog::register_logger(logger);
-
+    logger = spdlog::get("QPeltierUI");
     logger->info("Init QPeltierUI");
 
     ui->cmbWorkMode->addItem("Stopped", qToUnderlying(WorkMode::Stopped));
@@ -56,6 +25,19 @@ MainWindow::MainWindow(bool isSimulator, QWidget *parent) : isSimulator(isSimula
 
     ConfigureCharts();
 
+    m_devices = new DeviceManager(isSimulator, isNativeTty, this);
+    m_devices->setSimulatorDevices(simulatorDevices);
+    connect(m_devices, &DeviceManager::drained, this, &MainWindow::TelemetryDrained);
+    connect(m_devices, &DeviceManager::closed, this, &MainWindow::DeviceClosed);
+    connect(ui->btnDashboard, &QPushButton::clicked, this, [this]() {
+        if (m_dashboard == nullptr) {
+            m_dashboard = new DashboardWidget(m_devices, this);
+            connect(m_dashboard, &DashboardWidget::showDevice, this, &MainWindow::ShowDevice);
+        }
+        m_dashboard->show();
+        m_dashboard->raise();
+    });
+
     PopulateSerialPorts();
     connect(ui->cmbSerialPorts, &QComboBox::activated, [=](int index) {
         if (ui->cmbSerialPorts->itemData(index).toString() == "__refresh__") {
@@ -67,7 +49,9 @@ MainWindow::MainWindow(bool isSimulator, QWidget *parent) : isSimulator(isSimula
 
     connect(ui->btnConnectDisconnect, &QPushButton::clicked, [=]() {
         if (isConnected) {
-            disconnect(m_serialPortWorker, &SerialPortWorker::telemetryRecv, this, &MainWindow::Telemetry);
+            if (m_session) {
+                m_session->setSink({});
+            }
             QTimer::singleShot(0, this, [this]() {
                 SetDisconnected();
             });
@@ -77,6 +61,22 @@ MainWindow::MainWindow(bool isSimulator, QWidget *parent) : isSimulator(isSimula
     });
 
     connect(ui->btnRecordCurrent, &QPushButton::clicked, this, &MainWindow::buttonRecordClicked);
+    ConnectButtonsToSerialWorker();
+
+    m_parameters = new DeviceParameters(this);
+    connect(m_parameters, &DeviceParameters::finished, this, [this](bool ok, int failed) {
+        if (!ok) {
+            logger->warn("Parameters batch: {} requests failed", failed);
+        }
+    });
+    connect(ui->btnParametersRead, &QPushButton::clicked, this, [this]() {
+        m_parameters->readAll();
+    });
+    connect(ui->btnParametersWrite, &QPushButton::clicked, this, [this]() {
+        m_parameters->write(ParametersFromUi());
+    });
+    connect(ui->btnProfileLoad, &QPushButton::clicked, this, &MainWindow::buttonProfileLoadClicked);
+    connect(ui->btnProfileSave, &QPushButton::clicked, this, &MainWindow::buttonProfileSaveClicked);
 
     m_widgetsInTabs.append(ui->tabPageCommon);
     m_widgetsInTabs.append(ui->tabPageCurrent);
@@ -85,9 +85,17 @@ MainWindow::MainWindow(bool isSimulator, QWidget *parent) : isSimulator(isSimula
     for (auto w : m_widgetsInTabs) {
         w->setDisabled(true);
     }
+
+    m_current.resize(40);
+
+    m_statusTimer = new QTimer(this);
+    connect(m_statusTimer, &QTimer::timeout, this, &MainWindow::UpdateStatus);
+    m_statusTimer->start(1000);
 }
 
 MainWindow::~MainWindow() {
+    m_parameters->setWorker(nullptr);
+    m_devices->closeAll();
     delete ui;
 }
 
@@ -97,6 +105,7 @@ void MainWindow::ConfigureCharts() {
     m_chartCurrent->axisY()->setTitleText("Current, A");
     m_chartCurrent->axisY()->setRange(-1, 1);
     m_chartCurrent->setRecordParameters(500e-6, 10); // 500 мкс/тик, 10 секунд записи
+    m_chartCurrent->setAxisHysteresis(0.1);
 
     m_chartTemperature = new RecorderWidget();
     m_chartTemperature->legend()->hide();
@@ -104,33 +113,122 @@ void MainWindow::ConfigureCharts() {
     m_chartTemperature->axisY()->setRange(-1, 1);
     m_chartTemperature->setRecordParameters(20e-3, 30); // 20 мс/тик, 30 секунд записи
     m_chartTemperature->setVerticalRange(0.05);
+    m_chartTemperature->series()->setName("Measured");
+    m_channelTemperatureSetpoint = m_chartTemperature->addChannel("Setpoint", QColor(255, 170, 0));
+    m_chartTemperature->setChannelVisible(m_channelTemperatureSetpoint, false);
     
     ui->chartViewCurrent->setChart(m_chartCurrent);
     ui->chartViewTemperature->setChart(m_chartTemperature);
+
+    m_refresh = new RefreshScheduler(this);
+    m_refresh->addWidget(m_chartCurrent);
+    m_refresh->addWidget(m_chartTemperature);
+    if (auto s = screen()) {
+        m_refresh->setRefreshRate(s->refreshRate());
+    }
+    m_refresh->start();
+}
+
+/**
+ * @brief Ограничить частоту перерисовки графиков
+ * @param[in] fps - кадров в секунду, 0 - по частоте экрана
+ */
+void MainWindow::setFpsCap(double fps) {
+    m_refresh->setFpsCap(fps);
+    logger->info("Chart refresh interval {:.1f} ms", m_refresh->interval());
+}
+
+/**
+ * @brief Подключать контроллеры на шине RS-485 порта portName по отдельности, по адресам
+ */
+void MainWindow::addBus(const QString &portName, const QList<uint8_t> &addresses) {
+    m_devices->addBus(portName, addresses);
+    PopulateSerialPorts();
+}
+
+/**
+ * @brief Заменить график тока графиком потока с кольцевым буфером на GPU
+ * @param[in] openGl - OpenGL, если доступен, иначе программная отрисовка
+ */
+void MainWindow::useStreamingTrace(bool openGl) {
+    m_traceCurrent = StreamingTrace::create(openGl, this);
+    m_traceCurrent->setWindow(::round(m_graphCurrentShowTime / m_chartCurrent->timebase()) + 1);
+    logger->info("Current trace: {}", dynamic_cast<GlTraceWidget *>(m_traceCurrent) ? "OpenGL" : "software");
+
+    ui->verticalLayout->replaceWidget(ui->chartViewCurrent, m_traceCurrent->widget());
+    ui->chartViewCurrent->hide();
+    m_refresh->removeWidget(m_chartCurrent);
+    m_refresh->addTrace(m_traceCurrent);
 }
 
 void MainWindow::SetConnected() {
-    if (m_serialPortWorker) {
-        delete m_serialPortWorker;
+auto session = m_devices->open(ui->cmbSerialPorts->currentData().toString());
+    SelectSession(session);
+}
+
+/**
+ * @brief Показать устройство в подробном виде: графики, вкладки команд и запись главного окна
+ * @param[in] session - открытая сессия устройства. Предыдущее устройство остаётся подключённым
+ */
+void MainWindow::SelectSession(DeviceSession *session) {
+    if (m_session == session) {
+        return;
+    }
+
+    if (m_session) {
+        m_session->setSink({});
+        disconnect(m_serialPortWorker, nullptr, this, nullptr);
     }
+    // Запись прежнего устройства продолжается, она видна на общей панели
+    m_recordFileName.clear();
+    ui->btnRecordCurrent->setText("Start Record");
+    ui->lblRecordCurrentFileName->clear();
 
     m_chartCurrent->clear();
     m_chartTemperature->clear();
+    if (m_traceCurrent) {
+        m_traceCurrent->clear();
+    }
+    m_temperatureSetpoint = std::numeric_limits<double>::quiet_NaN();
+    m_chartTemperature->setChannelVisible(m_channelTemperatureSetpoint, false);
+    m_chartTemperature->legend()->hide();
+    ui->lblVersion->clear();
 
-    m_serialPortWorker = new SerialPortWorker(isSimulator);
-    connect(m_serialPortWorker, &SerialPortWorker::error, this, &MainWindow::SerialError, static_cast<Qt::ConnectionType>(Qt::QueuedConnection | Qt::SingleShotConnection));
-    connect(m_serialPortWorker, &SerialPortWorker::telemetryRecv, this, &MainWindow::Telemetry, Qt::QueuedConnection);
+    m_session = session;
+    m_serialPortWorker = session->worker();
     connect(m_serialPortWorker, &SerialPortWorker::commandExecute, this, &MainWindow::commandExecute, Qt::QueuedConnection);
-    ConnectButtonsToSerialWorker();
-    m_serialPortWorker->startReceiver(ui->cmbSerialPorts->currentData().toString(), 10);
+    m_parameters->setWorker(m_serialPortWorker);
+    ShowCachedParameters();
+    m_session->setSink([this](const TelemetryRecord &record) {
+        Telemetry(record);
+    });
+
+    if (m_session->isRecording()) {
+        m_recordFileName = m_session->recordFileName();
+        ui->btnRecordCurrent->setText("Stop Record");
+    }
 
     isConnected = true;
     ui->btnConnectDisconnect->setText("Disconnect");
+    int index = ui->cmbSerialPorts->findData(session->portName());
+    if (index >= 0) {
+        ui->cmbSerialPorts->setCurrentIndex(index);
+    }
     ui->cmbSerialPorts->setEnabled(false);
 
     for (auto w : m_widgetsInTabs) {
         w->setEnabled(true);
     }
+    logger->info("Showing {}", session->portName().toStdString());
+}
+
+/**
+ * @brief Открыть устройство с общей панели в подробном виде
+ */
+void MainWindow::ShowDevice(const QString &portName) {
+    SelectSession(m_devices->open(portName));
+    raise();
+    activateWindow();
 }
 
 void MainWindow::ConnectButtonsToSerialWorker() {
@@ -228,34 +326,47 @@ void MainWindow::buttonSetClicked() {
 }
 
 void MainWindow::buttonRecordClicked() {
+    if (!m_session) {
+        return;
+    }
+
     if (m_recordFileName.isEmpty()) {
+        m_recordFileName = QString("Record-%1.qpr").arg(QDateTime::currentDateTime().toString("dd.MM.yy-hh_mm_ss_zzz"));
+        if (!m_session->startRecording(m_recordFileName, m_chartCurrent->timebase())) {
+            m_recordFileName.clear();
+            return;
+        }
         ui->btnRecordCurrent->setText("Stop Record");
-        m_recordFileName = QString("Record-%1.csv").arg(QDateTime::currentDateTime().toString("dd.MM.yy-hh_mm_ss_zzz"));
         ui->lblRecordCurrentFileName->setText(QString("`%1`").arg(m_recordFileName));
-        if (m_recordFile) {
-            m_recordFile->close();
-            m_recordFile = nullptr;
-        }
-
-        m_recordFile = new QFile(m_recordFileName);
-        m_recordFile->open(QIODevice::WriteOnly | QIODevice::Truncate);
-        m_recordFile->write(QString("Index; Time [s]; Current[A]\n").toLatin1());
-        m_recordIndex = 0;
     } else {
-        ui->btnRecordCurrent->setText("Start Record");
-        ui->lblRecordCurrentFileName->setText(QString("`%1` stopped, %2 s").arg(m_recordFileName).arg(RecordIndexToTime(m_recordIndex, m_chartCurrent->timebase())));
-        m_recordFileName.clear();
-        m_recordFile->close();
-        m_recordFile = nullptr;
+        m_session->stopRecording();
+        RecordStopped();
     }
 }
-   
+
+/**
+ * @brief Запись устройства в подробном виде остановлена: кнопкой, с общей панели, по ошибке или при отключении
+ */
+void MainWindow::RecordStopped() {
+    if (m_recordFileName.isEmpty()) {
+        return;
+    }
+
+    ui->btnRecordCurrent->setText("Start Record");
+    ui->lblRecordCurrentFileName->setText(QString("`%1` stopped, %2 s").arg(m_recordFileName).arg(RecordTime(m_session ? m_session->recordedTime() : 0)));
+    m_recordFileName.clear();
+}
 
 void MainWindow::SetDisconnected() {
-    if (m_serialPortWorker) {
-        delete m_serialPortWorker;
-        m_serialPortWorker = nullptr;
+    m_parameters->setWorker(nullptr);
+    RecordStopped();
+    if (m_session) {
+        const auto portName = m_session->portName();
+        m_session->setSink({});
+        m_session = nullptr;
+        m_devices->close(portName);
     }
+    m_serialPortWorker = nullptr;
 
     isConnected = false;
     ui->btnConnectDisconnect->setText("Connect");
@@ -264,184 +375,258 @@ void MainWindow::SetDisconnected() {
     for (auto w : m_widgetsInTabs) {
         w->setDisabled(true);
     }
+}
 
-    if (!m_recordFileName.isEmpty()) {
-        buttonRecordClicked();
+/**
+ * @brief Сессия устройства закрыта: с общей панели или по ошибке порта
+ */
+void MainWindow::DeviceClosed(const QString &portName, const QString &error) {
+    if (!m_session || m_session->portName() != portName) {
+        return;
+    }
+
+    if (!error.isEmpty()) {
+        logger->error("{}", error.toStdString());
     }
+    SetDisconnected();
 }
 
 void MainWindow::PopulateSerialPorts() {
     logger->debug("Populate serial ports");
     ui->cmbSerialPorts->clear();
+auto ports = m_devices->availablePorts();
+    for (const auto &p : ports) {
+        ui->cmbSerialPorts->addItem(p.first, p.second);
+    }
     if (isSimulator) {
         logger->info("Set simulator mode");
-        ui->cmbSerialPorts->addItem("Simulator");
         return;
     }
-
-auto ports = SerialPortWorker::availablePorts();
-    for (const auto &p : ports) {
-        ui->cmbSerialPorts->addItem(p.first, p.second);
-    }
     ui->cmbSerialPorts->addItem("Refresh", "__refresh__");
     ui->btnConnectDisconnect->setDisabled(ui->cmbSerialPorts->count() == 1);
 }
 
-void MainWindow::SerialError(const QString &s) {
-    logger->error("{}", s.toStdString());
-    SetDisconnected();
-}
+void MainWindow::UpdateStatus() {
+auto frame = m_refresh->stats();
+QString status = QString("Render: %1 fps, %2 ms (max %3 ms), skipped %4")
+        .arg(frame.fps, 0, 'f', 1).arg(frame.frameTime, 0, 'f', 2).arg(frame.frameTimeMax, 0, 'f', 2).arg(frame.skipped);
 
+    if (m_devices->count() > 1) {
+        status += QString("; Devices: %1").arg(m_devices->count());
+    }
+    if (m_serialPortWorker == nullptr) {
+        ui->statusbar->showMessage(status);
+        return;
+    }
 
-void MainWindow::Telemetry(const QList<double> &current, double temperature, uint32_t status) {
-    m_chartCurrent->addData(current);
-    m_chartTemperature->addData(temperature);
-    RecordTelemetry(current, temperature);
+    auto frames = m_serialPortWorker->frameStats();
+    status += QString("; Frames: lost %1 (%2%), gaps %3, max burst %4, dup %5, reord %6")
+        .arg(frames.lost).arg(frames.lossRate() * 100, 0, 'f', 2).arg(frames.gaps).arg(frames.maxBurst)
+        .arg(frames.duplicates).arg(frames.reordered);
 
-    auto cur_mean = std::accumulate(current.begin(), current.end(), 0.0) / current.size();
-    ui->labelTemperature->setText(tr("Temperature %1 °C").arg(temperature, 0, 'g', 4, '0'));    
-    ui->labelCurrent->setText(tr("Current: %1 A").arg(cur_mean, 0, 'g', 3, '0'));
-}
+    auto commands = m_serialPortWorker->commandStats();
+    status += QString("; Commands: %1 in flight, %2 queued, retries %3, timeouts %4")
+        .arg(commands.inFlight).arg(commands.pending).arg(commands.retransmits).arg(commands.timeouts);
+
+    const auto &cache = m_session->cache();
+    status += QString("; Cache: hits %1, misses %2").arg(cache->hits()).arg(cache->misses());
 
-QString MainWindow::RecordIndexToTime(qint64 index, double timebase) {
-    return QString("%1").arg(index * timebase, 4, 'g', 5, ' ').replace('.', ',');
+    auto &queue = m_serialPortWorker->telemetryQueue();
+    status += QString("; Queue: max %1/%2, dropped %3").arg(queue.highWaterMark()).arg(queue.capacity()).arg(queue.drops());
+    if (!isSimulator) {
+        auto backlog = m_serialPortWorker->backlog();
+        status += QString("; Backlog: %1 B, %2 frames (max %3 B, %4 frames)")
+            .arg(backlog.bytes).arg(backlog.frames).arg(backlog.maxBytes).arg(backlog.maxFrames);
+    }
+    ui->statusbar->showMessage(status);
 }
-    
-void MainWindow::RecordTelemetry(const QList<double> &current, double temperature) {
-    if (m_recordFile == nullptr) {
+
+/**
+ * @brief Обновить показания после разбора очередей телеметрии. Вызывается по DeviceManager::drained
+ */
+void MainWindow::TelemetryDrained() {
+    if (m_session && !m_recordFileName.isEmpty() && !m_session->isRecording()) {
+        RecordStopped();
+    }
+    if (!m_telemetryUpdated) {
         return;
     }
+    m_telemetryUpdated = false;
 
-    QString time;
-    for (int i = 0; i < current.size(); i++) {
-        time = RecordIndexToTime(m_recordIndex, m_chartCurrent->timebase());
-        QString value = QString("%1").arg(current[i], 4, 'g', 5, '0').replace('.', ',');
-        QString rec;
-        if (i != 0) {
-            rec = QString("%1; %2; %3\n").arg(m_recordIndex).arg(time).arg(value);
-        } else {
-            QString value_t = QString("%1").arg(temperature, 4, 'g', 5, '0').replace('.', ',');
-            rec = QString("%1; %2; %3; %4\n").arg(m_recordIndex).arg(time).arg(value).arg(value_t);
+    auto cur_mean = std::accumulate(m_current.begin(), m_current.end(), 0.0) / m_current.size();
+    ui->labelTemperature->setText(tr("Temperature %1 °C").arg(m_temperature, 0, 'g', 4, '0'));    
+    ui->labelCurrent->setText(tr("Current: %1 A").arg(cur_mean, 0, 'g', 3, '0'));
+    if (!m_recordFileName.isEmpty()) {
+        ui->lblRecordCurrentFileName->setText(QString("`%1` - %2 s").arg(m_recordFileName).arg(RecordTime(m_session->recordedTime())));
+    }
+}
+
+void MainWindow::Telemetry(const TelemetryRecord &record) {
+const auto &frame = record.frame;
+    if (record.lost > 0) {
+        m_chartCurrent->addGap(static_cast<qsizetype>(record.lost) * frame.current.size());
+        m_chartTemperature->addGap(record.lost);
+        if (m_traceCurrent) {
+            m_traceCurrent->addGap(static_cast<size_t>(record.lost) * frame.current.size());
         }
-        m_recordFile->write(rec.toLatin1());
-        m_recordIndex++;
     }
 
-    ui->lblRecordCurrentFileName->setText(QString("`%1` - %2 s").arg(m_recordFileName).arg(time));
+    for (int i = 0; i < m_current.size(); i++) {
+        m_current[i] = frame.currentAmps(i);
+    }
+    m_temperature = frame.temperature;
+
+    m_chartCurrent->addData(m_current);
+    m_chartTemperature->addData(m_temperature);
+    // Пока уставка неизвестна, канал скрыт и повторяет измерение, чтобы не сбить общую ось времени
+    m_chartTemperature->addData(m_channelTemperatureSetpoint, std::isnan(m_temperatureSetpoint) ? m_temperature : m_temperatureSetpoint);
+    if (m_traceCurrent) {
+        m_traceCurrent->append(m_current.constData(), m_current.size());
+    }
+    m_telemetryUpdated = true;
+}
+
+QString MainWindow::RecordTime(double seconds) {
+    return QString("%1").arg(seconds, 4, 'g', 5, ' ').replace('.', ',');
 }
 
 void MainWindow::commandExecute(SerialPortWorker::CommandError error, tec::Commands command, const QByteArray &data) {
     logger->info("Command {} executed: {}. Size {}", qToUnderlying(command), static_cast<int>(error), data.size());
 
     switch (error) {
-        case SerialPortWorker::CommandError::Busy:
-            for (auto w : m_widgetsInTabs) {
-                w->setDisabled(true);
-            }
-            break;
-
         case SerialPortWorker::CommandError::NoError:
             ParseGetRequest(command, data);
+            break;
+
         case SerialPortWorker::CommandError::Error:
         case SerialPortWorker::CommandError::TimeoutError:
-            for (auto w : m_widgetsInTabs) {
-                w->setEnabled(true);
-            }
+            logger->warn("Command {} failed: {}", qToUnderlying(command), error == SerialPortWorker::CommandError::TimeoutError ? "timeout" : "error");
+            break;
+
+        default:
+            // Команды идут через очередь с окном, вкладки не блокируются на время ответа
             break;
     }
 }
 
 
 void MainWindow::ParseGetRequest(tec::Commands command, const QByteArray &data) {
-float f_value;
-uint32_t ui32_value;
-WorkMode wm;
-
-    switch (command) {
-        case tec::Commands::VoltageGetSet:
-            if (data.size() == sizeof(f_value)) {
-                ::memcpy(&f_value, data.constData(), data.size());
-                ui->spinDebugOutVoltage->setValue(f_value);
+double value;
+    if (auto p = ParameterSet::fromReply(command, data, value)) {
+        ParameterToUi(*p, value);
+        if (*p == ParameterSet::TemperatureSetpoint) {
+            if (std::isnan(m_temperatureSetpoint)) {
+                m_chartTemperature->setChannelVisible(m_channelTemperatureSetpoint, true);
+                m_chartTemperature->legend()->show();
             }
-            break;
+            m_temperatureSetpoint = value;
+        }
+        return;
+    }
 
-        case tec::Commands::CurrentPidGetSet:
-            if (data.size() == sizeof(f_value) + 1) {
-                ::memcpy(&f_value, data.constData() + 1, data.size() - 1);
-                switch (static_cast<PidVariableType>(data[0])) {
-                    case PidVariableType::Proportional:
-                        ui->spinCurrentPidP->setValue(f_value);
-                        break;
-                    case PidVariableType::Integral:
-                        ui->spinCurrentPidI->setValue(f_value);
-                        break;
-                    case PidVariableType::Derivative:
-                        ui->spinCurrentPidD->setValue(f_value);
-                        break;
-                    case PidVariableType::WindUp:
-                        ui->spinCurrentPidWindUp->setValue(f_value);
-                        break;
-                }
-            }
-            break;
+    if (command == tecdesc::Version::command) {
+        if (auto version = tecdesc::Version::decode(tecdesc::bytes(data))) {
+            auto [hw_ver, sw_ver] = *version;
+            QString ver = QString("Version HW: %1, SW: %2").arg(toVersion(hw_ver)).arg(toVersion(sw_ver));
+            ui->lblVersion->setText(ver);
+        }
+    }
+}
 
-        case tec::Commands::WorkModeSetGet:
-            if (data.size() == 1) {
-                int index = ui->cmbWorkMode->findData(data[0]);
-                if (index >= 0) {
-                    ui->cmbWorkMode->setCurrentIndex(data[0]);
-                }
-            }
-            break;
+/**
+ * @brief Показать значения, подтверждённые в прошлых подключениях к этому порту, до первого чтения
+ */
+void MainWindow::ShowCachedParameters() {
+const auto &cache = m_session->cache();
+    for (const auto &[key, entry] : cache->entries()) {
+        if (entry.confirmed < 0) {
+            continue;
+        }
+        logger->debug("Cached command {}/{}: {} ms old{}", key.first, key.second, cache->age(entry), entry.dirty ? ", dirty" : "");
+        ParseGetRequest(static_cast<tec::Commands>(key.first), entry.value);
+    }
+}
 
-        case tec::Commands::CurrentStabGetSet:
-            if (data.size() == 4) {
-                ::memcpy(&f_value, data.constData(), data.size());
-                ui->spinDebugCurrent->setValue(f_value);
-            }
-            break;
+QDoubleSpinBox *MainWindow::ParameterSpinBox(ParameterSet::Parameter p) const {
+    switch (p) {
+        case ParameterSet::CurrentPidP:             return ui->spinCurrentPidP;
+        case ParameterSet::CurrentPidI:             return ui->spinCurrentPidI;
+        case ParameterSet::CurrentPidD:             return ui->spinCurrentPidD;
+        case ParameterSet::CurrentPidWindUp:        return ui->spinCurrentPidWindUp;
+        case ParameterSet::TemperaturePidP:         return ui->spinTemperaturePidP;
+        case ParameterSet::TemperaturePidI:         return ui->spinTemperaturePidI;
+        case ParameterSet::TemperaturePidD:         return ui->spinTemperaturePidD;
+        case ParameterSet::TemperaturePidWindUp:    return ui->spinTemperaturePidWindup;
+        case ParameterSet::TemperatureSetpoint:     return ui->spinTemperature;
+        case ParameterSet::DebugCurrent:            return ui->spinDebugCurrent;
+        case ParameterSet::OutputVoltage:           return ui->spinDebugOutVoltage;
+        default:                                    return nullptr;
+    }
+}
 
-        case tec::Commands::TemperaturePidGetSet:
-            if (data.size() == sizeof(f_value) + 1) {
-                ::memcpy(&f_value, data.constData() + 1, data.size() - 1);
-                switch (static_cast<PidVariableType>(data[0])) {
-                    case PidVariableType::Proportional:
-                        ui->spinTemperaturePidP->setValue(f_value);
-                        break;
-                    case PidVariableType::Integral:
-                        ui->spinTemperaturePidI->setValue(f_value);
-                        break;
-                    case PidVariableType::Derivative:
-                        ui->spinTemperaturePidD->setValue(f_value);
-                        break;
-                    case PidVariableType::WindUp:
-                        ui->spinTemperaturePidWindup->setValue(f_value);
-                        break;
-                }
-            }
-            break;
+/**
+ * @brief Значения всех параметров, как они заданы в интерфейсе
+ */
+ParameterSet MainWindow::ParametersFromUi() const {
+ParameterSet ret;
+    for (int i = 0; i < ParameterSet::Count; i++) {
+        auto p = static_cast<ParameterSet::Parameter>(i);
+        if (auto spin = ParameterSpinBox(p)) {
+            ret.set(p, spin->value());
+        }
+    }
+    ret.set(ParameterSet::Mode, ui->cmbWorkMode->currentData().toInt());
+    return ret;
+}
 
-        case tec::Commands::TemperatureStabGetSet:
-            if (data.size() == 4) {
-                ::memcpy(&f_value, data.constData(), data.size());
-                ui->spinTemperature->setValue(f_value);
-            }
-            break;
+void MainWindow::ParameterToUi(ParameterSet::Parameter p, double value) {
+    if (auto spin = ParameterSpinBox(p)) {
+        spin->setValue(value);
+    } else if (p == ParameterSet::Mode) {
+        int index = ui->cmbWorkMode->findData(static_cast<int>(value));
+        if (index >= 0) {
+            ui->cmbWorkMode->setCurrentIndex(index);
+        }
+    }
+}
 
-        case tec::Commands::VersionGet:
-            if (data.size() == 8) {
-                uint32_t hw_ver;
-                uint32_t sw_ver;
-                ::memcpy(&hw_ver, reinterpret_cast<const void *>(data.constData()    ), 4);
-                ::memcpy(&sw_ver, reinterpret_cast<const void *>(data.constData() + 4), 4);
-                QString ver = QString("Version HW: %1, SW: %2").arg(toVersion(hw_ver)).arg(toVersion(sw_ver));
-                ui->lblVersion->setText(ver);
-            }
-            break;
+/**
+ * @brief Загрузить профиль в интерфейс. В контроллер он уходит по "Write changed"
+ */
+void MainWindow::buttonProfileLoadClicked() {
+auto fileName = QFileDialog::getOpenFileName(this, tr("Load profile"), QString(), tr("Profiles (*.json)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
 
-        default:
-            break;
+ParameterSet profile;
+QString err;
+    if (!profile.load(fileName, &err)) {
+        logger->error("{}", err.toStdString());
+        return;
+    }
+
+    for (int i = 0; i < ParameterSet::Count; i++) {
+        auto p = static_cast<ParameterSet::Parameter>(i);
+        if (profile.has(p)) {
+            ParameterToUi(p, profile.value(p));
+        }
+    }
+    logger->info("Profile {} loaded", fileName.toStdString());
+}
+
+void MainWindow::buttonProfileSaveClicked() {
+auto fileName = QFileDialog::getSaveFileName(this, tr("Save profile"), QString(), tr("Profiles (*.json)"));
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+QString err;
+    if (!ParametersFromUi().save(fileName, &err)) {
+        logger->error("{}", err.toStdString());
+        return;
     }
+    logger->info("Profile {} saved", fileName.toStdString());
 }
 
 QString MainWindow::toVersion(uint32_t version) {
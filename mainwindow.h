@@ -2,14 +2,23 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QHash>
 #include <QFile>
+#include <QPointer>
+#include <QTimer>
 #include <QChart>
 #include <QValueAxis>
 #include <QXYSeries>
 #include <QLineSeries>
+#include <QDoubleSpinBox>
 
 #include "serialportworker.h"
+#include "devicemanager.h"
+#include "dashboardwidget.h"
 #include "recorderwidget.h"
+#include "refreshscheduler.h"
+#include "streamingtrace.h"
+#include "deviceparameters.h"
 
 
 QT_BEGIN_NAMESPACE
@@ -22,10 +31,11 @@ class MainWindow : public QMainWindow {
     Q_OBJECT
 
 public:
-    MainWindow(bool isSimulator, QWidget *parent = nullptr);
+    MainWindow(bool isSimulator, bool isNativeTty = false, int simulatorDevices = 1, QWidget *parent = nullptr);
     ~MainWindow();
 
     bool isSimulator;
+    bool isNativeTty;
     bool isConnected = false;
 
     void SetConnected();
@@ -33,10 +43,19 @@ public:
     void PopulateSerialPorts();
     std::shared_ptr<spdlog::logger> logger;
     static QString toVersion(uint32_t version);
+    void setFpsCap(double fps);
+    void addBus(const QString &portName, const QList<uint8_t> &addresses);
+    void useStreamingTrace(bool openGl);
     
 private:
     Ui::MainWindow *ui;
+    DeviceManager *m_devices;
+    DashboardWidget *m_dashboard = nullptr;
+    QPointer<DeviceSession> m_session;          ///< Устройство в подробном виде
     SerialPortWorker *m_serialPortWorker = nullptr;
+    void SelectSession(DeviceSession *session);
+    void ShowDevice(const QString &portName);
+    void DeviceClosed(const QString &portName, const QString &error);
 
     void ConnectButtonsToSerialWorker();
     double m_graphTemperatureShowTime = 30;     ///< Длина отображения графика температуры, секунд
@@ -46,23 +65,40 @@ private:
 
     RecorderWidget *m_chartCurrent;
     RecorderWidget *m_chartTemperature;
+    int m_channelTemperatureSetpoint;           ///< Канал уставки на графике температуры
+    double m_temperatureSetpoint = std::numeric_limits<double>::quiet_NaN();
+    RefreshScheduler *m_refresh;
+    StreamingTrace *m_traceCurrent = nullptr;   ///< Заменяет график тока при --gl-trace
     QList<QWidget *> m_widgetsInTabs;
 
     void ParseGetRequest(tec::Commands command, const QByteArray &data);
+
+    DeviceParameters *m_parameters;
+    void ShowCachedParameters();
+    QDoubleSpinBox *ParameterSpinBox(ParameterSet::Parameter p) const;
+    ParameterSet ParametersFromUi() const;
+    void ParameterToUi(ParameterSet::Parameter p, double value);
     QString m_recordFileName;
-    QFile *m_recordFile = nullptr;
-    qint64 m_recordIndex = -1;
-    void RecordTelemetry(const QList<double> &current, double temperature);
-    QString RecordIndexToTime(qint64 index, double timebase = 500e-6);
+    void RecordStopped();
+    QString RecordTime(double seconds);
+
+    QTimer *m_statusTimer;
+    void UpdateStatus();
+
+    QList<double> m_current;                    ///< Ток последнего кадра, А. Память выделяется один раз
+    double m_temperature = 0;
+    bool m_telemetryUpdated = false;
+    void TelemetryDrained();
+    void Telemetry(const TelemetryRecord &record);
     
 public slots:
-    void SerialError(const QString &s);
-    void Telemetry(const QList<double> &current, double temperature, uint32_t status);
     void commandExecute(SerialPortWorker::CommandError error, tec::Commands command, const QByteArray &data);
     
     void buttonGetClicked();
     void buttonSetClicked();
     void buttonRecordClicked();
+    void buttonProfileLoadClicked();
+    void buttonProfileSaveClicked();
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,82 @@
+#include "parametercache.h"
+
+
+/**
+ * @brief Определить, какой параметр затрагивает команда
+ * @param[in] command - команда
+ * @param[in] payload - данные команды: размер запроса чтения или записи из описателя команды
+ */
+std::optional<ParameterCache::Access> ParameterCache::access(tec::Commands command, const QByteArray &payload) {
+std::optional<Access> ret;
+    tecdesc::Registry::find(command, [&](auto descriptor) {
+        using D = decltype(descriptor);
+        if constexpr (D::ReplyLayout::count > 0) {
+            const Key key(qToUnderlying(command), tecdesc::Registry::replyKey(command, tecdesc::bytes(payload)));
+            if (static_cast<size_t>(payload.size()) == D::ReadRequest::size) {
+                ret = Access{key, false};
+            } else if constexpr (D::writable) {
+                if (static_cast<size_t>(payload.size()) == D::WriteRequest::size) {
+                    ret = Access{key, true};
+                }
+            }
+        }
+    });
+    return ret;
+}
+
+/**
+ * @brief Найти подтверждённое значение не старше maxAgeMs
+ * @return false - значения нет, оно грязное или устарело
+ */
+bool ParameterCache::lookup(const Key &key, qint64 maxAgeMs, QByteArray &value) {
+const QMutexLocker locker(&m_lock);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end() || it->second.dirty || it->second.confirmed < 0 || age(it->second) > maxAgeMs) {
+        m_misses++;
+        return false;
+    }
+
+    m_hits++;
+    value = it->second.value;
+    return true;
+}
+
+void ParameterCache::confirm(const Key &key, const QByteArray &value) {
+const QMutexLocker locker(&m_lock);
+    auto &entry = m_entries[key];
+    entry.value = value;
+    entry.confirmed = m_clock.elapsed();
+    entry.dirty = false;
+}
+
+void ParameterCache::markDirty(const Key &key) {
+const QMutexLocker locker(&m_lock);
+    m_entries[key].dirty = true;
+}
+
+void ParameterCache::clear() {
+const QMutexLocker locker(&m_lock);
+    m_entries.clear();
+}
+
+/**
+ * @brief Копия всех записей, в порядке ключей
+ */
+QList<QPair<ParameterCache::Key, ParameterCache::Entry>> ParameterCache::entries() const {
+const QMutexLocker locker(&m_lock);
+QList<QPair<Key, Entry>> ret;
+    for (const auto &[key, entry] : m_entries) {
+        ret.append(qMakePair(key, entry));
+    }
+    return ret;
+}
+
+uint64_t ParameterCache::hits() const {
+const QMutexLocker locker(&m_lock);
+    return m_hits;
+}
+
+uint64_t ParameterCache::misses() const {
+const QMutexLocker locker(&m_lock);
+    return m_misses;
+}
@@ -0,0 +1,60 @@
+#ifndef PARAMETERCACHE_H
+#define PARAMETERCACHE_H
+
+#include <map>
+#include <optional>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <commands.hpp>
+#include "commanddescriptors.h"
+
+/**
+ * @brief Последние подтверждённые контроллером значения параметров
+ *
+ * Ключ - команда и тип переменной PID (-1 для остальных команд). Значение хранится в формате ответа на чтение,
+ * он же формат данных команды записи. Запись без подтверждения помечает значение грязным: оно больше не
+ * выдаётся, пока не будет прочитано или подтверждено заново.
+ *
+ * Кэш общий для GUI и потока порта и переживает переподключение к тому же порту.
+ */
+class ParameterCache {
+public:
+    using Key = std::pair<uint8_t, int>;
+
+    struct Entry {
+        QByteArray value;
+        qint64 confirmed = -1;      ///< Время подтверждения, мс от создания кэша
+        bool dirty = false;         ///< Отправлена запись, подтверждения нет
+    };
+
+    /// Обращение к параметру: ключ и признак записи. Пусто, если команда не кэшируется
+    struct Access {
+        Key key;
+        bool write;
+    };
+    static std::optional<Access> access(tec::Commands command, const QByteArray &payload);
+
+    ParameterCache() { m_clock.start(); }
+
+    bool lookup(const Key &key, qint64 maxAgeMs, QByteArray &value);
+    void confirm(const Key &key, const QByteArray &value);
+    void markDirty(const Key &key);
+    void clear();
+
+    qint64 age(const Entry &entry) const { return entry.confirmed < 0 ? -1 : m_clock.elapsed() - entry.confirmed; }
+    QList<QPair<Key, Entry>> entries() const;
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+    mutable QMutex m_lock;
+    std::map<Key, Entry> m_entries;
+    QElapsedTimer m_clock;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+};
+
+#endif // PARAMETERCACHE_H
@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+
+#include <spdlog/spdlog.h>
+#include "acquisitiondaemon.h"
+#include "logging.h"
+
+int main(int argc, char *argv[]) {
+QCoreApplication a(argc, argv);
+
+    if (!QDir("logs").exists()) {
+        if (!QDir().mkdir("logs")) {
+            std::fprintf(stderr, "Cannot create logs folder. Check permissions\n");
+            return 1;
+        }
+    }
+
+    QCoreApplication::setOrganizationName("MeshLab");
+    QCoreApplication::setApplicationName("qpeltierd");
+    QCoreApplication::setApplicationVersion(_APP_VERSION);
+
+QCommandLineParser parser;
+    parser.setApplicationDescription("qpeltierd - Thermoelectric controller telemetry acquisition");
+    parser.addHelpOption();
+    parser.addVersionOption();
+QCommandLineOption simulatorOption(QStringList() << "s" << "simulator", "Enable simulator mode");
+    parser.addOption(simulatorOption);
+QCommandLineOption simulatorDevicesOption(QStringList() << "simulator-devices", "Number of simulated controllers", "count", "1");
+    parser.addOption(simulatorDevicesOption);
+QCommandLineOption nativeTtyOption(QStringList() << "native-tty", "Use termios/epoll serial transport (Linux only)");
+    parser.addOption(nativeTtyOption);
+QCommandLineOption busOption(QStringList() << "bus", "RS-485 bus with addressed controllers, e.g. ttyUSB0:1,2,3. May be repeated", "port:addresses");
+    parser.addOption(busOption);
+QCommandLineOption portOption(QStringList() << "p" << "port", "Device to acquire from, all found devices by default. May be repeated", "port");
+    parser.addOption(portOption);
+QCommandLineOption profileOption(QStringList() << "profile", "Parameter profile written to every controller at startup", "file.json");
+    parser.addOption(profileOption);
+QCommandLineOption outputOption(QStringList() << "o" << "output", "Directory for telemetry records", "dir", ".");
+    parser.addOption(outputOption);
+QCommandLineOption noRecordOption(QStringList() << "no-record", "Do not record telemetry");
+    parser.addOption(noRecordOption);
+QCommandLineOption statusOption(QStringList() << "status-interval", "Device status log period, seconds. 0 - off", "seconds", "10");
+    parser.addOption(statusOption);
+QCommandLineOption logLevelOption(QStringList() << "log-level", "trace, debug, info, warning, error", "level", "info");
+    parser.addOption(logLevelOption);
+    parser.process(a);
+
+    logging::init(SPDLOG_FILENAME_T("logs/qpeltierd.log"), spdlog::level::from_str(parser.value(logLevelOption).toStdString()));
+auto logger = logging::create("qpeltierd");
+    logger->info("Init qpeltierd {}", _APP_VERSION);
+
+DeviceManager devices(parser.isSet(simulatorOption), parser.isSet(nativeTtyOption));
+    devices.setSimulatorDevices(parser.value(simulatorDevicesOption).toInt());
+    for (const auto &bus : parser.values(busOption)) {
+        QString portName;
+        QList<uint8_t> addresses;
+        if (!DeviceManager::parseBus(bus, portName, addresses)) {
+            logger->error("Invalid bus '{}', expected port:address[,address...]", bus.toStdString());
+            return 1;
+        }
+        devices.addBus(portName, addresses);
+    }
+
+AcquisitionDaemon::Options options;
+    options.ports = parser.values(portOption);
+    options.outputDir = parser.value(outputOption);
+    options.record = !parser.isSet(noRecordOption);
+    options.statusInterval = parser.value(statusOption).toInt();
+    if (parser.isSet(profileOption)) {
+        ParameterSet profile;
+        QString err;
+        if (!profile.load(parser.value(profileOption), &err)) {
+            logger->error("{}", err.toStdString());
+            return 1;
+        }
+        options.profile = profile;
+        logger->info("Profile {} loaded", parser.value(profileOption).toStdString());
+    }
+
+AcquisitionDaemon daemon(&devices, options);
+    QObject::connect(&daemon, &AcquisitionDaemon::finished, &a, &QCoreApplication::quit, Qt::QueuedConnection);
+    AcquisitionDaemon::installSignalHandlers();
+    if (!daemon.start()) {
+        spdlog::shutdown();
+        return 1;
+    }
+
+    auto exit_code = a.exec();
+    spdlog::shutdown();
+    return exit_code;
+}
@@ -0,0 +1,122 @@
+#include <QPainter>
+#include "rastertracewidget.h"
+
+
+RasterTraceWidget::RasterTraceWidget(QWidget *parent) : QWidget(parent) {
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setWindow(m_window);
+}
+
+void RasterTraceWidget::append(const double *data, size_t count) {
+    m_samples.append(data, count);
+    m_extrema.append(data, count);
+    m_dirty = true;
+}
+
+void RasterTraceWidget::addGap(size_t samples) {
+    if (samples == 0) {
+        return;
+    }
+
+    const uint64_t begin = m_samples.total();
+    m_hold.assign(samples, m_samples.isEmpty() ? 0.0 : m_samples.at(begin - 1));
+    append(m_hold.data(), m_hold.size());
+
+    while (!m_gaps.empty() && m_gaps.front().end <= m_samples.first()) {
+        m_gaps.pop_front();
+    }
+    m_gaps.push_back(Gap{begin, m_samples.total()});
+}
+
+void RasterTraceWidget::clear() {
+    m_samples.clear();
+    m_extrema.clear();
+    m_gaps.clear();
+    m_decimator.invalidate();
+    m_dirty = true;
+}
+
+void RasterTraceWidget::setWindow(size_t samples) {
+    m_window = std::max<size_t>(samples, 2);
+    m_samples.reset(m_window);
+    m_extrema.reset(m_window);
+    m_gaps.clear();
+    m_decimator.invalidate();
+    m_dirty = true;
+}
+
+void RasterTraceWidget::setRange(double lo, double hi) {
+    m_lo = lo;
+    m_hi = hi;
+    m_dirty = true;
+}
+
+bool RasterTraceWidget::render() {
+    if (!m_dirty) {
+        return false;
+    }
+
+    m_dirty = false;
+    update();
+    return true;
+}
+
+void RasterTraceWidget::paintEvent(QPaintEvent *event) {
+QPainter painter(this);
+const QRectF area = rect();
+
+    painter.fillRect(area, palette().color(QPalette::Base));
+    if (m_samples.size() < 2 || area.width() < 2) {
+        return;
+    }
+
+    // X точек - номер отсчёта, tick = 1
+    m_decimator.decimate(m_samples, m_samples.first(), m_samples.total(), static_cast<int>(area.width()), 1.0, m_points);
+
+    double lo = m_lo;
+    double hi = m_hi;
+    if (lo >= hi) {
+        lo = m_extrema.min(m_extrema.first());
+        hi = m_extrema.max(m_extrema.first());
+        const double margin = std::max((hi - lo) * 0.05, 1e-6);
+        lo -= margin;
+        hi += margin;
+    }
+
+    // Последний отсчёт у правого края, как в GlTraceWidget
+    const double right = static_cast<double>(m_samples.total() - 1);
+    const double sx = (area.width() - 1) / static_cast<double>(m_window - 1);
+    const double sy = (area.height() - 1) / (hi - lo);
+    for (auto &p : m_points) {
+        p = QPointF(area.right() - (right - p.x()) * sx, area.bottom() - (p.y() - lo) * sy);
+    }
+
+    // Пропуск, начавшийся не правее точки, отделяет её от предыдущих; точки внутри пропуска не рисуются
+    painter.setPen(palette().color(QPalette::Highlight));
+    auto gap = m_gaps.cbegin();
+    qsizetype from = 0;
+    for (qsizetype i = 0; i < m_points.size(); i++) {
+        const double x = m_points[i].x();
+        while (gap != m_gaps.cend() && area.right() - (right - gap->begin) * sx <= x) {
+            DrawRun(painter, from, i);
+            from = i;
+            if (x < area.right() - (right - gap->end) * sx) {
+                from = i + 1;
+                break;
+            }
+            ++gap;
+        }
+    }
+    DrawRun(painter, from, m_points.size());
+}
+
+/**
+ * @brief Нарисовать точки [begin, end) одной ломаной
+ */
+void RasterTraceWidget::DrawRun(QPainter &painter, qsizetype begin, qsizetype end) const {
+    if (end - begin > 1) {
+        painter.drawPolyline(m_points.constData() + begin, static_cast<int>(end - begin));
+    } else if (end - begin == 1) {
+        painter.drawPoint(m_points[begin]);
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef RASTERTRACEWIDGET_H
+#define RASTERTRACEWIDGET_H
+
+#include <QList>
+#include <QPointF>
+#include <QWidget>
+#include <deque>
+#include <vector>
+#include "decimator.h"
+#include "samplering.h"
+#include "slidingminmax.h"
+#include "streamingtrace.h"
+
+QT_FORWARD_DECLARE_CLASS(QPainter);
+
+/**
+ * @brief Программная отрисовка графика потока без OpenGL
+ *
+ * Окно прореживается Decimator до min/max на столбец пикселей и рисуется ломаной QPainter, прерванной
+ * на пропусках. Пропуск заполняется последним значением.
+ */
+class RasterTraceWidget : public QWidget, public StreamingTrace {
+    Q_OBJECT
+
+public:
+    explicit RasterTraceWidget(QWidget *parent = nullptr);
+
+    QWidget *widget() override { return this; }
+    void append(const double *data, size_t count) override;
+    void addGap(size_t samples) override;
+    void clear() override;
+    void setWindow(size_t samples) override;
+    void setRange(double lo, double hi) override;
+    bool render() override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    SampleRing m_samples;
+    SlidingMinMax m_extrema;
+    Decimator m_decimator;
+    QList<QPointF> m_points;
+    size_t m_window = 20001;
+    double m_lo = 0;
+    double m_hi = 0;
+    bool m_dirty = false;
+
+    struct Gap {
+        uint64_t begin;
+        uint64_t end;
+    };
+    std::deque<Gap> m_gaps;         ///< Пропуски в окне, номера отсчётов [begin, end)
+    std::vector<double> m_hold;
+
+    void DrawRun(QPainter &painter, qsizetype begin, qsizetype end) const;
+};
+
+#endif // RASTERTRACEWIDGET_H
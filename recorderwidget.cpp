@@ -1,3 +1,7 @@
+#include <cmath>
+#include <QGraphicsRectItem>
+#include <QGraphicsSceneMouseEvent>
+#include <QGraphicsSceneWheelEvent>
 #include <QLineSeries>
 #include <QValueAxis>
 
@@ -6,10 +10,6 @@
 
 RecorderWidget::RecorderWidget(QGraphicsItem *parent) : QChart(QChart::ChartTypeCartesian, parent, Qt::Widget) {
 
-    m_series = new QLineSeries();
-    m_series->setUseOpenGL(true);
-    addSeries(m_series);
-
     m_axisX = new QValueAxis();
     m_axisX->setLabelFormat("%g");
     m_axisX->setTitleText("Samples");
@@ -21,93 +21,402 @@ RecorderWidget::RecorderWidget(QGraphicsItem *parent) : QChart(QChart::ChartType
     addAxis(m_axisX, Qt::AlignBottom);
     addAxis(m_axisY, Qt::AlignLeft);
 
-    m_series->attachAxis(m_axisX);
-    m_series->attachAxis(m_axisY);
+    addChannel(QString(), QColor());
+}
+
+/**
+ * @brief Добавить канал с общей осью времени
+ * @param[in] name - имя для легенды
+ * @param[in] color - цвет линии, недействительный - цвет темы
+ * @return Номер канала
+ */
+int RecorderWidget::addChannel(const QString &name, const QColor &color) {
+auto channel = std::make_unique<Channel>();
+
+    channel->series = new QLineSeries();
+    channel->series->setUseOpenGL(true);
+    channel->series->setName(name);
+    addSeries(channel->series);
+    if (color.isValid()) {
+        channel->series->setColor(color);
+    }
+    channel->series->attachAxis(m_axisX);
+    channel->series->attachAxis(m_axisY);
+
+    channel->samples.reset(m_bufferMaxSize);
+    channel->extrema.reset(m_bufferMaxSize);
+    if (!m_channels.empty()) {
+        channel->decimator.setMode(m_channels.front()->decimator.mode());
+    }
+    m_channels.push_back(std::move(channel));
+    setHistoryBudget(m_historyBudget);
+    m_dirty = true;
+    return channelCount() - 1;
+}
+
+void RecorderWidget::setChannelVisible(int channel, bool visible) {
+auto &c = *m_channels[channel];
+
+    c.visible = visible;
+    c.series->setVisible(visible);
+    if (!visible) {
+        c.points.clear();
+    }
+    m_dirty = true;
+}
+
+void RecorderWidget::setChannelColor(int channel, const QColor &color) {
+    m_channels[channel]->series->setColor(color);
+}
+
+/**
+ * @brief Масштаб канала: отображаемое значение = отсчёт * scale + offset
+ */
+void RecorderWidget::setChannelScale(int channel, double scale, double offset) {
+    m_channels[channel]->scale = scale;
+    m_channels[channel]->offset = offset;
+    m_dirty = true;
 }
 
 void RecorderWidget::clear() {
-    m_buffer.clear();
-    m_currentTickTime = 0;
+    for (auto &c : m_channels) {
+        c->samples.clear();
+        c->extrema.clear();
+        c->history.clear();
+        c->decimator.invalidate();
+    }
+    m_gaps.clear();
+    m_follow = true;
+    m_viewSamples = m_bufferMaxSize;
+    m_dirty = true;
     m_currentTime = std::numeric_limits<double>::lowest();
     updateAsisX();
 }
 
 
+void RecorderWidget::addData(int channel, const double *data, qsizetype count) {
+auto &c = *m_channels[channel];
+
+    if (count <= 0) {
+        return;
+    }
+
+    c.samples.append(data, count);
+    c.extrema.append(data, count);
+    c.history.append(data, count);
+    m_dirty |= m_follow && c.visible;
+}
+
+void RecorderWidget::addData(int channel, double data) {
+    addData(channel, &data, 1);
+}
+
+/**
+ * @brief Отметить потерянные данные
+ *
+ * Чтобы ось времени не сдвинулась, каждый канал дополняется samples отсчётами со своим последним значением,
+ * отрезок отмечается на графике полосой.
+ * @param[in] samples - отсчётов потеряно
+ */
+void RecorderWidget::addGap(qsizetype samples) {
+    if (samples <= 0) {
+        return;
+    }
+
+    const uint64_t begin = m_channels.front()->samples.total();
+    for (auto &c : m_channels) {
+        const double hold = c->samples.isEmpty() ? 0.0 : c->samples.at(c->samples.total() - 1);
+        m_hold.assign(samples, hold);
+        c->samples.append(m_hold.data(), m_hold.size());
+        c->extrema.append(m_hold.data(), m_hold.size());
+        c->history.append(m_hold.data(), m_hold.size());
+    }
+
+    m_gaps.push_back(Gap{begin, begin + static_cast<uint64_t>(samples)});
+    if (m_gaps.size() > GapsMaximum) {
+        m_gaps.pop_front();
+    }
+    m_dirty |= m_follow;
+}
+
+void RecorderWidget::addData(const double *data, qsizetype count) {
+    addData(0, data, count);
+}
+
 void RecorderWidget::addData(const QList<double> &data) {
-static const int resolution = 1;
-    int free_elements = m_bufferMaxSize - m_buffer.size();
-    if (free_elements >= data.size()) {
-        // Места много, добавляем к буферу
-        for (int i(0); i < data.size(); ++i) {
-            m_buffer.append(QPointF(m_currentTickTime, data[i]));
-            m_currentTickTime += m_tickTime;
+    addData(data.constData(), data.size());
+}
+
+void RecorderWidget::addData(double data) {
+    addData(0, &data, 1);
+}
+
+/**
+ * @brief Перерисовать график, если есть изменения. Вызывается по такту RefreshScheduler
+ * @return true, если график перерисован
+ */
+bool RecorderWidget::render() {
+    if (!m_dirty) {
+        return false;
+    }
+
+    Render();
+    return true;
+}
+
+/**
+ * @brief Проредить окно каждого видимого канала до ширины графика, перенести в серии и обновить оси
+ */
+void RecorderWidget::Render() {
+double min = std::numeric_limits<double>::max();
+double max = std::numeric_limits<double>::lowest();
+const int columns = std::max(1, static_cast<int>(plotArea().width()));
+const uint64_t end = ViewEnd();
+const uint64_t begin = end > m_viewSamples ? end - m_viewSamples : 0;
+
+    for (auto &c : m_channels) {
+        if (c->visible) {
+            RenderChannel(*c, begin, end, columns, min, max);
         }
+    }
+
+    auto right = (static_cast<double>(end) - 1) * m_tickTime;
+    m_axisX->setRange(right - (m_viewSamples - 1) * m_tickTime, right);
+    if (min <= max) {
+        UpdateAxisY(min, max);
+    }
+    RenderGaps(begin, end);
+    if (m_follow) {
+        m_currentTime = right;
+    }
+    m_dirty = false;
+}
+
+/**
+ * @brief Проредить окно канала и расширить min/max на его диапазон
+ *
+ * Окно, целиком лежащее в кольце последних отсчётов, прореживается по кольцу, более старая история и окна
+ * шире кольца берутся из пирамиды.
+ */
+void RecorderWidget::RenderChannel(Channel &channel, uint64_t begin, uint64_t end, int columns, double &min, double &max) {
+double lo = std::numeric_limits<double>::max();
+double hi = std::numeric_limits<double>::lowest();
+
+    end = std::min(end, channel.samples.total());
+    if (begin >= channel.samples.first() && end <= channel.samples.total()) {
+        channel.decimator.decimate(channel.samples, begin, end, columns, m_tickTime, channel.points);
     } else {
-        // Буфера не хватает на полный блок дата, смещаем и добиваем до буфера
-        if (free_elements > 0) {
-            for (int i(0); i < free_elements; ++i) {
-                m_buffer.append(QPointF(m_currentTickTime, data[i]));
-            }
+        channel.history.query(begin, end, columns, m_tickTime, channel.points);
+    }
+
+    const bool scaled = channel.scale != 1 || channel.offset != 0;
+    if (scaled) {
+        for (auto &p : channel.points) {
+            p.setY(p.y() * channel.scale + channel.offset);
         }
+    }
 
-        int start = 0;
-        const int availableSamples = int(data.size()) / resolution;
-        if (availableSamples < m_bufferMaxSize) {
-            start = m_bufferMaxSize - availableSamples;
-            const int offset = data.size() - free_elements;
-            for (int s = 0; s < start; ++s) {
-                m_buffer[s].setY(m_buffer.at(s + offset).y());
-                m_buffer[s].setX(m_buffer.at(s + offset).x());
-            }
-
-            for (int s = start; s < m_bufferMaxSize; ++s) {
-                m_buffer[s].setX(m_currentTickTime);
-                m_currentTickTime += m_tickTime;
-            }
+    if (end == channel.extrema.total() && begin >= channel.extrema.first() && begin < end) {
+        lo = channel.extrema.min(begin) * channel.scale + channel.offset;
+        hi = channel.extrema.max(begin) * channel.scale + channel.offset;
+        if (lo > hi) {
+            std::swap(lo, hi);
         }
-        
-        int sample = 0;
-        for (int s = start; s < m_bufferMaxSize; ++s, sample += resolution) {
-            m_buffer[s].setY(data[sample]);
+    } else {
+        for (const auto &p : std::as_const(channel.points)) {
+            lo = std::min(lo, p.y());
+            hi = std::max(hi, p.y());
         }
     }
+    channel.series->replace(channel.points);
 
-    auto left = m_buffer[0].x();
-    auto right = m_buffer[m_buffer.size() - 1].x();
-    if (left > -0.0001) {
-        left = -m_recordTime + right;
+    if (!channel.points.isEmpty()) {
+        min = std::min(min, lo);
+        max = std::max(max, hi);
     }
+}
 
-    if (right - m_currentTime > 0.1) {
-        m_series->replace(m_buffer);
-        m_axisX->setRange(left, right);
-        m_currentTime = right;
+/**
+ * @brief Подстроить ось Y под диапазон данных
+ *
+ * С гистерезисом ось расширяется с запасом, как только данные выходят за неё, и сужается, только когда
+ * она шире нужного больше чем на 4 * m_hysteresis диапазона данных.
+ */
+void RecorderWidget::UpdateAxisY(double min, double max) {
+const double low = min - m_vericalRange;
+const double high = max + m_vericalRange;
+
+    if (m_hysteresis <= 0) {
+        m_axisY->setRange(low, high);
+        return;
+    }
+
+    const double margin = (high - low) * m_hysteresis;
+    const double span = m_axisY->max() - m_axisY->min();
+    if (low < m_axisY->min() || high > m_axisY->max() || span > (high - low) + 4 * margin) {
+        m_axisY->setRange(low - margin, high + margin);
+    }
+}
 
-        double min = std::numeric_limits<double>::max();
-        double max = std::numeric_limits<double>::lowest();
-        for (const auto &p : m_buffer) {
-            if (p.y() < min) {
-                min = p.y();
-            }
+/**
+ * @brief Расставить полосы пропусков, попадающих в окно [begin, end)
+ */
+void RecorderWidget::RenderGaps(uint64_t begin, uint64_t end) {
+const QRectF area = plotArea();
+const double left = m_axisX->min();
+const double width = m_axisX->max() - left;
+qsizetype used = 0;
 
-            if (p.y() > max) {
-                max = p.y();
-            }
+    auto it = std::lower_bound(m_gaps.begin(), m_gaps.end(), begin, [](const Gap &gap, uint64_t index) {
+        return gap.end <= index;
+    });
+    for (; width > 0 && it != m_gaps.end() && it->begin < end && used < GapMarkersMaximum; ++it) {
+        const double x0 = std::max(area.left(), area.left() + ((it->begin - 0.5) * m_tickTime - left) / width * area.width());
+        const double x1 = std::min(area.right(), area.left() + ((it->end - 0.5) * m_tickTime - left) / width * area.width());
+
+        if (used == m_gapMarkers.size()) {
+            auto marker = new QGraphicsRectItem(this);
+            marker->setPen(Qt::NoPen);
+            marker->setBrush(QColor(255, 0, 0, 60));
+            marker->setZValue(1000);
+            m_gapMarkers.append(marker);
         }
+        m_gapMarkers[used]->setRect(QRectF(x0, area.top(), std::max(x1 - x0, 1.0), area.height()));
+        m_gapMarkers[used]->setVisible(true);
+        used++;
+    }
 
-        m_axisY->setRange(min - m_vericalRange, max + m_vericalRange);
+    for (; used < m_gapMarkers.size(); used++) {
+        m_gapMarkers[used]->setVisible(false);
     }
 }
 
-void RecorderWidget::addData(double data) {
-QVector<double> d({data});
-    addData(d);
+uint64_t RecorderWidget::ViewEnd() const {
+    const uint64_t total = m_channels.front()->samples.total();
+    return m_follow ? total : std::min(m_viewEnd, total);
+}
+
+/**
+ * @brief Вернуть окно к последним данным с исходной шириной
+ */
+void RecorderWidget::follow() {
+    m_follow = true;
+    m_viewSamples = m_bufferMaxSize;
+    m_dragging = false;
+    m_dirty = true;
+}
+
+/**
+ * @brief Колесо - масштаб окна относительно курсора, при слежении правый край остаётся на последнем отсчёте
+ */
+void RecorderWidget::wheelEvent(QGraphicsSceneWheelEvent *event) {
+const QRectF area = plotArea();
+
+    if (event->delta() == 0 || area.width() <= 0) {
+        event->ignore();
+        return;
+    }
+
+    const uint64_t end = ViewEnd();
+    const uint64_t begin = end > m_viewSamples ? end - m_viewSamples : 0;
+    const double factor = std::pow(1.25, -event->delta() / 120.0);
+    const uint64_t total = m_channels.front()->samples.total();
+    const uint64_t maxSamples = std::max<uint64_t>(m_channels.front()->history.total(), m_bufferMaxSize);
+    const auto samples = static_cast<uint64_t>(std::clamp(m_viewSamples * factor, 16.0, static_cast<double>(maxSamples)));
+
+    if (!m_follow) {
+        const double ratio = std::clamp((event->pos().x() - area.left()) / area.width(), 0.0, 1.0);
+        const double anchor = begin + ratio * m_viewSamples;
+        const double newEnd = anchor + (end - anchor) * samples / m_viewSamples;
+        m_viewEnd = static_cast<uint64_t>(std::clamp(newEnd, static_cast<double>(std::min(samples, total)),
+                                                     static_cast<double>(total)));
+    }
+    m_viewSamples = samples;
+    m_dirty = true;
+    event->accept();
+}
+
+/**
+ * @brief Перетаскивание левой кнопкой - прокрутка по истории
+ */
+void RecorderWidget::mousePressEvent(QGraphicsSceneMouseEvent *event) {
+    if (event->button() != Qt::LeftButton) {
+        QChart::mousePressEvent(event);
+        return;
+    }
+
+    m_dragging = true;
+    m_dragX = event->pos().x();
+    m_dragViewEnd = ViewEnd();
+    event->accept();
+}
+
+void RecorderWidget::mouseMoveEvent(QGraphicsSceneMouseEvent *event) {
+const QRectF area = plotArea();
+
+    if (!m_dragging || area.width() <= 0) {
+        QChart::mouseMoveEvent(event);
+        return;
+    }
+
+    const double shift = (event->pos().x() - m_dragX) / area.width() * m_viewSamples;
+    const double total = static_cast<double>(m_channels.front()->samples.total());
+    const double newEnd = std::clamp(m_dragViewEnd - shift, std::min(static_cast<double>(m_viewSamples), total), total);
+
+    m_follow = newEnd >= total;
+    m_viewEnd = static_cast<uint64_t>(newEnd);
+    m_dirty = true;
+    event->accept();
+}
+
+void RecorderWidget::mouseReleaseEvent(QGraphicsSceneMouseEvent *event) {
+    if (m_dragging && event->button() == Qt::LeftButton) {
+        m_dragging = false;
+        event->accept();
+        return;
+    }
+    QChart::mouseReleaseEvent(event);
+}
+
+/**
+ * @brief Двойной щелчок - вернуться к слежению за данными
+ */
+void RecorderWidget::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event) {
+    follow();
+    event->accept();
 }
 
 void RecorderWidget::setVerticalRange(double range) {
     m_vericalRange = range;    
 }
 
+void RecorderWidget::setDecimationMode(Decimator::Mode mode) {
+    for (auto &c : m_channels) {
+        c->decimator.setMode(mode);
+    }
+}
+
+/**
+ * @brief Установить гистерезис автомасштаба оси Y
+ * @param[in] fraction - запас в долях диапазона данных с каждой стороны, 0 - без гистерезиса
+ */
+void RecorderWidget::setAxisHysteresis(double fraction) {
+    m_hysteresis = std::max(fraction, 0.0);
+}
+
+/**
+ * @brief Установить бюджет памяти истории графика, более старые данные вытесняются во временный файл
+ * @param[in] bytes - объём на все каналы, байт. Бюджет и предел файла вытеснения делятся между каналами поровну
+ */
+void RecorderWidget::setHistoryBudget(size_t bytes) {
+    m_historyBudget = bytes;
+    const auto channels = std::max<size_t>(m_channels.size(), 1);
+    for (auto &c : m_channels) {
+        c->history.setMemoryBudget(bytes / channels);
+        c->history.setSpillLimit(SamplePyramid::SpillLimit / static_cast<qint64>(channels));
+    }
+}
+
 /**
  * @brief Установить параметры самописца
  * @param[in] tick - длительность тика, секунд 
@@ -119,8 +428,14 @@ void RecorderWidget::setRecordParameters(double tick, double recordTime) {
     
     updateAsisX();
     m_bufferMaxSize = ::round(m_recordTime / m_tickTime) + 1;
-    m_buffer.clear();
-    m_buffer.reserve(m_bufferMaxSize);
+    for (auto &c : m_channels) {
+        c->samples.reset(m_bufferMaxSize);
+        c->extrema.reset(m_bufferMaxSize);
+        c->history.clear();
+        c->decimator.invalidate();
+    }
+    m_viewSamples = m_bufferMaxSize;
+    m_follow = true;
     m_currentTime = 0;
 }
 
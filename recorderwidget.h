@@ -1,8 +1,16 @@
 #ifndef RECORDERWIDGET_H
 #define RECORDERWIDGET_H
 
+#include <deque>
+#include <memory>
 #include <QChart>
+#include <vector>
+#include "decimator.h"
+#include "samplepyramid.h"
+#include "samplering.h"
+#include "slidingminmax.h"
 
+QT_FORWARD_DECLARE_CLASS(QGraphicsRectItem);
 QT_FORWARD_DECLARE_CLASS(QLineSeries);
 QT_FORWARD_DECLARE_CLASS(QValueAxis);
 QT_FORWARD_DECLARE_CLASS(QXYSeries);
@@ -13,29 +21,92 @@ class RecorderWidget : public QChart  {
 public:
     explicit RecorderWidget(QGraphicsItem *parent = nullptr);
 
-    QLineSeries *series() const { return m_series; }
+    int addChannel(const QString &name, const QColor &color);
+    int channelCount() const { return static_cast<int>(m_channels.size()); }
+    QLineSeries *series(int channel = 0) const { return m_channels[channel]->series; }
+    void setChannelVisible(int channel, bool visible);
+    void setChannelColor(int channel, const QColor &color);
+    void setChannelScale(int channel, double scale, double offset = 0);
 
+    void addData(const double *data, qsizetype count);
     void addData(const QList<double> &data);
     void addData(double data);
+    void addData(int channel, const double *data, qsizetype count);
+    void addData(int channel, double data);
+    void addGap(qsizetype samples);
     void clear();
+    bool render();
+    bool isDirty() const { return m_dirty; }
 
     void setRecordParameters(double tick, double recordTime);
     double timebase() const { return m_tickTime; }
     void setVerticalRange(double range);
+    void setDecimationMode(Decimator::Mode mode);
+    void setHistoryBudget(size_t bytes);
+    void setAxisHysteresis(double fraction);
+
+    bool isFollowing() const { return m_follow; }
+    void follow();
+
+protected:
+    void wheelEvent(QGraphicsSceneWheelEvent *event) override;
+    void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event) override;
 
 private:
-    QLineSeries *m_series;
+    /**
+     * @brief Канал самописца. Отсчёты всех каналов идут с общим тиком, номер отсчёта - общая ось времени,
+     * поэтому данные в каналы добавляются синхронно с каналом 0
+     */
+    struct Channel {
+        QLineSeries *series = nullptr;
+        SampleRing samples;         ///< Отсчёты за m_recordTime, X отсчёта = номер * m_tickTime
+        SlidingMinMax extrema;      ///< Экстремумы окна слежения для оси Y
+        SamplePyramid history;      ///< Вся запись для масштабирования и прокрутки
+        Decimator decimator;
+        QList<QPointF> points;      ///< Прореженная копия для серии, заполняется только при перерисовке
+        double scale = 1;           ///< Отображаемое значение = отсчёт * scale + offset
+        double offset = 0;
+        bool visible = true;        ///< Скрытый канал копит данные, но не прореживается и не рисуется
+    };
+
     QValueAxis *m_axisX;
     QValueAxis *m_axisY;
+    std::vector<std::unique_ptr<Channel>> m_channels;   ///< Канал 0 задаёт конец окна слежения
+
+    /// Пропуск данных: отсчёты [begin, end) заполнены последним значением и отмечены на графике
+    struct Gap {
+        uint64_t begin;
+        uint64_t end;
+    };
+    static constexpr size_t GapsMaximum = 4096;         ///< Хранимых пропусков, старые забываются
+    static constexpr qsizetype GapMarkersMaximum = 256; ///< Отметок пропусков на экране
+    std::deque<Gap> m_gaps;
+    QList<QGraphicsRectItem *> m_gapMarkers;
+    std::vector<double> m_hold;
 
-    QList<QPointF> m_buffer;
+    bool m_dirty = false;       ///< Есть изменения, не показанные на графике
+    bool m_follow = true;       ///< Окно следует за последним отсчётом
+    uint64_t m_viewEnd = 0;     ///< Конец окна (номер отсчёта), если окно не следует за данными
+    uint64_t m_viewSamples = 1; ///< Ширина окна, отсчётов
+    double m_dragX = 0;
+    uint64_t m_dragViewEnd = 0;
+    bool m_dragging = false;
     double m_vericalRange = 0.1;      
-    double m_tickTime;          ///< Время одного тика, секунд
-    double m_recordTime;        ///< Полное отображаемое время, секунд
-    int m_bufferMaxSize;
-    double m_currentTickTime = 0;
+    double m_hysteresis = 0;    ///< Запас оси Y в долях диапазона данных, 0 - ось следует за данными точно
+    double m_tickTime = 1;      ///< Время одного тика, секунд
+    double m_recordTime = 1;    ///< Полное отображаемое время, секунд
+    int m_bufferMaxSize = 2;
+    size_t m_historyBudget = 64 * 1024 * 1024;     ///< Бюджет памяти истории на все каналы
 
     void updateAsisX();
+    void Render();
+    void RenderChannel(Channel &channel, uint64_t begin, uint64_t end, int columns, double &min, double &max);
+    uint64_t ViewEnd() const;
+    void UpdateAxisY(double min, double max);
+    void RenderGaps(uint64_t begin, uint64_t end);
 
     double m_currentTime = std::numeric_limits<double>::lowest();
 };
@@ -0,0 +1,106 @@
+#include "recorderwidget.h"
+#include "streamingtrace.h"
+#include "refreshscheduler.h"
+
+
+RefreshScheduler::RefreshScheduler(QObject *parent) : QObject(parent) {
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &RefreshScheduler::Frame);
+}
+
+void RefreshScheduler::addWidget(RecorderWidget *widget) {
+    m_widgets.append(widget);
+}
+
+void RefreshScheduler::removeWidget(RecorderWidget *widget) {
+    m_widgets.removeAll(widget);
+}
+
+void RefreshScheduler::addTrace(StreamingTrace *trace) {
+    m_traces.append(trace);
+}
+
+/**
+ * @brief Установить частоту обновления экрана
+ * @param[in] hz - частота, Гц
+ */
+void RefreshScheduler::setRefreshRate(double hz) {
+    m_refreshRate = hz > 0 ? hz : 60;
+    if (m_timer.isActive()) {
+        m_timer.setInterval(qRound(interval()));
+    }
+}
+
+/**
+ * @brief Ограничить частоту перерисовки
+ * @param[in] fps - кадров в секунду, 0 - по частоте экрана
+ */
+void RefreshScheduler::setFpsCap(double fps) {
+    m_fpsCap = std::max(fps, 0.0);
+    if (m_timer.isActive()) {
+        m_timer.setInterval(qRound(interval()));
+    }
+}
+
+/**
+ * @brief Период такта, мс
+ */
+double RefreshScheduler::interval() const {
+    double rate = m_refreshRate;
+    if (m_fpsCap > 0) {
+        rate = std::min(rate, m_fpsCap);
+    }
+    return 1000.0 / rate;
+}
+
+void RefreshScheduler::start() {
+    m_clock.start();
+    m_nextFrame = 0;
+    m_windowStart = 0;
+    m_windowFrames = 0;
+    m_windowTime = 0;
+    m_windowMax = 0;
+    m_stats = Stats();
+    m_timer.start(qRound(interval()));
+}
+
+void RefreshScheduler::stop() {
+    m_timer.stop();
+}
+
+void RefreshScheduler::Frame() {
+const qint64 period = static_cast<qint64>(interval() * 1e6);
+const qint64 now = m_clock.nsecsElapsed();
+bool rendered = false;
+
+    // Такты, на которые GUI опоздал, не догоняются
+    if (m_nextFrame != 0 && now > m_nextFrame + period) {
+        m_stats.skipped += (now - m_nextFrame) / period;
+    }
+    m_nextFrame = now + period;
+
+    for (auto w : std::as_const(m_widgets)) {
+        rendered |= w->render();
+    }
+    for (auto t : std::as_const(m_traces)) {
+        rendered |= t->render();
+    }
+
+    if (rendered) {
+        const double frameTime = (m_clock.nsecsElapsed() - now) / 1e6;
+        m_windowFrames++;
+        m_windowTime += frameTime;
+        m_windowMax = std::max(m_windowMax, frameTime);
+    }
+
+    const qint64 elapsed = now - m_windowStart;
+    if (elapsed >= 1000000000) {
+        m_stats.fps = m_windowFrames * 1e9 / elapsed;
+        m_stats.frameTime = m_windowFrames ? m_windowTime / m_windowFrames : 0;
+        m_stats.frameTimeMax = m_windowMax;
+        m_windowStart = now;
+        m_windowFrames = 0;
+        m_windowTime = 0;
+        m_windowMax = 0;
+    }
+}
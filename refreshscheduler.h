@@ -0,0 +1,62 @@
+#ifndef REFRESHSCHEDULER_H
+#define REFRESHSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+class RecorderWidget;
+class StreamingTrace;
+
+/**
+ * @brief Общий такт перерисовки графиков
+ *
+ * По таймеру с частотой обновления экрана (или меньше, если задан предел FPS) перерисовывает все изменившиеся
+ * графики в одном проходе, поэтому они показывают данные на один и тот же момент. Если кадр не уложился
+ * в период, пропущенные такты не догоняются, а учитываются в skipped. Приём телеметрии от такта не зависит.
+ */
+class RefreshScheduler : public QObject {
+    Q_OBJECT
+
+public:
+    struct Stats {
+        double fps = 0;             ///< Отрисованных кадров за последнюю секунду
+        double frameTime = 0;       ///< Среднее время подготовки кадра (прореживание, обновление серий), мс
+        double frameTimeMax = 0;    ///< Наибольшее время кадра, мс
+        uint64_t skipped = 0;       ///< Пропущено тактов всего
+    };
+
+    explicit RefreshScheduler(QObject *parent = nullptr);
+
+    void addWidget(RecorderWidget *widget);
+    void removeWidget(RecorderWidget *widget);
+    void addTrace(StreamingTrace *trace);
+    void setRefreshRate(double hz);
+    void setFpsCap(double fps);
+    double interval() const;
+
+    void start();
+    void stop();
+
+    Stats stats() const { return m_stats; }
+
+private:
+    QTimer m_timer;
+    QList<RecorderWidget *> m_widgets;
+    QList<StreamingTrace *> m_traces;
+    double m_refreshRate = 60;
+    double m_fpsCap = 0;            ///< 0 - без ограничения, по частоте экрана
+
+    QElapsedTimer m_clock;
+    qint64 m_nextFrame = 0;         ///< Время следующего такта по m_clock, нс
+    qint64 m_windowStart = 0;
+    int m_windowFrames = 0;
+    double m_windowTime = 0;
+    double m_windowMax = 0;
+    Stats m_stats;
+
+    void Frame();
+};
+
+#endif // REFRESHSCHEDULER_H
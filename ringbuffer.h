@@ -0,0 +1,58 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * @brief Кольцевой буфер байт фиксированной ёмкости с курсорами чтения и записи
+ *
+ * Ёмкость округляется вверх до степени двойки. Запись и чтение идут непрерывными отрезками: writeSpan()/commit()
+ * и readSpan()/consume(), поэтому данные никогда не сдвигаются и стоимость не зависит от заполненности.
+ */
+class ByteRingBuffer {
+public:
+    explicit ByteRingBuffer(size_t capacity) {
+        size_t c = 1;
+        while (c < capacity) {
+            c <<= 1;
+        }
+        m_buffer.resize(c);
+        m_mask = c - 1;
+    }
+
+    size_t capacity() const { return m_buffer.size(); }
+    size_t size() const { return m_write - m_read; }
+    size_t free() const { return capacity() - size(); }
+    bool isEmpty() const { return m_write == m_read; }
+    void clear() { m_read = m_write = 0; }
+
+    /// Непрерывный свободный участок для записи
+    std::span<uint8_t> writeSpan() {
+        const size_t pos = m_write & m_mask;
+        const size_t len = std::min(free(), capacity() - pos);
+        return std::span<uint8_t>(m_buffer.data() + pos, len);
+    }
+
+    void commit(size_t n) { m_write += n; }
+
+    /// Непрерывный заполненный участок для чтения
+    std::span<const uint8_t> readSpan() const {
+        const size_t pos = m_read & m_mask;
+        const size_t len = std::min(size(), capacity() - pos);
+        return std::span<const uint8_t>(m_buffer.data() + pos, len);
+    }
+
+    void consume(size_t n) { m_read += n; }
+
+private:
+    std::vector<uint8_t> m_buffer;
+    size_t m_mask = 0;
+    size_t m_read = 0;      ///< Счётчик прочитанных байт, позиция в буфере - m_read & m_mask
+    size_t m_write = 0;     ///< Счётчик записанных байт
+};
+
+#endif // RINGBUFFER_H
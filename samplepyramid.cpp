@@ -0,0 +1,203 @@
+#include <limits>
+#include "samplepyramid.h"
+
+
+SamplePyramid::SamplePyramid() {
+    logger = spdlog::get("QPeltierUI");
+    m_raw.setFile(&m_spill);
+    for (auto &level : m_bins) {
+        level.setFile(&m_spill);
+    }
+}
+
+void SamplePyramid::clear() {
+    m_raw.clear();
+    for (auto &level : m_bins) {
+        level.clear();
+    }
+    m_pending.fill(Accumulator());
+    m_spillFull = false;
+    if (m_spill.isOpen()) {
+        m_spill.resize(0);
+    }
+}
+
+/**
+ * @brief Установить бюджет памяти
+ * @param[in] bytes - наибольший объём блоков в памяти, байт
+ */
+void SamplePyramid::setMemoryBudget(size_t bytes) {
+    m_budget = bytes;
+    EnforceBudget();
+}
+
+size_t SamplePyramid::memoryBytes() const {
+size_t bytes = m_raw.memoryBytes();
+
+    for (const auto &level : m_bins) {
+        bytes += level.memoryBytes();
+    }
+    return bytes;
+}
+
+void SamplePyramid::append(const double *data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        m_raw.append(data[i]);
+        Push(1, data[i], data[i]);
+    }
+    EnforceBudget();
+}
+
+/**
+ * @brief Добавить элемент в накопитель уровня, законченный элемент уходит в хранилище и выше
+ */
+void SamplePyramid::Push(int level, double min, double max) {
+    if (level >= Levels) {
+        return;
+    }
+
+    auto &acc = m_pending[level - 1];
+    if (acc.count == 0) {
+        acc.min = min;
+        acc.max = max;
+    } else {
+        acc.min = std::min(acc.min, min);
+        acc.max = std::max(acc.max, max);
+    }
+
+    if (++acc.count == Factor) {
+        m_bins[level - 1].append(Bin{static_cast<float>(acc.min), static_cast<float>(acc.max)});
+        acc.count = 0;
+        Push(level + 1, acc.min, acc.max);
+    }
+}
+
+/**
+ * @brief Уложиться в бюджет памяти: вытеснить старые блоки в файл, при заполненном или недоступном файле - отбросить их
+ */
+void SamplePyramid::EnforceBudget() {
+    if (memoryBytes() <= m_budget) {
+        return;
+    }
+
+    if (!m_spillFull && !m_spill.isOpen() && !m_spill.open()) {
+        logger->warn("Cannot open history spill file: {}, evicted history is dropped", m_spill.errorString().toStdString());
+        m_spillFull = true;
+    }
+
+    // Сначала вытесняются исходные отсчёты - к ним обращаются только при сильном увеличении
+    while (memoryBytes() > m_budget) {
+        if (!m_spillFull && m_spill.size() + static_cast<qint64>(SpillStore<double>::ChunkBytes) > m_spillLimit) {
+            logger->warn("History spill file reached {} MB, evicted history is dropped", m_spillLimit / (1024 * 1024));
+            m_spillFull = true;
+        }
+
+        bool spilled = m_spillFull ? m_raw.dropOldest() : m_raw.spillOldest();
+        for (size_t k = 0; !spilled && k < m_bins.size(); k++) {
+            spilled = m_spillFull ? m_bins[k].dropOldest() : m_bins[k].spillOldest();
+        }
+        if (!spilled) {
+            if (!m_spillFull && m_spill.error() != QFileDevice::NoError) {
+                logger->warn("History spill failed: {}, evicted history is dropped", m_spill.errorString().toStdString());
+                m_spillFull = true;
+                continue;
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Построить огибающую для отрезка [begin, end)
+ * @param[in] columns - ширина графика, пикселей
+ * @param[in] tick - период отсчёта, секунд
+ * @param[out] out - по две точки (min, max) на столбец в порядке следования, содержимое заменяется
+ */
+void SamplePyramid::query(uint64_t begin, uint64_t end, int columns, double tick, QList<QPointF> &out) const {
+    out.resize(0);
+    end = std::min(end, total());
+    if (begin >= end) {
+        return;
+    }
+
+    columns = std::max(columns, 1);
+    const uint64_t spc = std::max<uint64_t>(1, (end - begin + columns - 1) / columns);
+    int level = 0;
+    uint64_t width = 1;
+    while (level + 1 < Levels && width * Factor <= spc) {
+        width *= Factor;
+        level++;
+    }
+
+uint64_t column = UINT64_MAX;
+double cmin = 0;
+double cmax = 0;
+double xmin = 0;
+double xmax = 0;
+
+    auto flush = [&]() {
+        if (column == UINT64_MAX) {
+            return;
+        }
+        if (xmin == xmax) {
+            out.append(QPointF(xmin * tick, cmin));
+            if (cmin != cmax) {
+                out.append(QPointF(xmax * tick, cmax));
+            }
+        } else if (xmin < xmax) {
+            out.append(QPointF(xmin * tick, cmin));
+            out.append(QPointF(xmax * tick, cmax));
+        } else {
+            out.append(QPointF(xmax * tick, cmax));
+            out.append(QPointF(xmin * tick, cmin));
+        }
+    };
+
+    // index - номер первого отсчёта элемента, x - его положение на оси в отсчётах
+    auto add = [&](uint64_t index, double x, double lo, double hi) {
+        const uint64_t c = index / spc;
+        if (c != column) {
+            flush();
+            column = c;
+            cmin = lo;
+            cmax = hi;
+            xmin = xmax = x;
+            return;
+        }
+        if (lo < cmin) {
+            cmin = lo;
+            xmin = x;
+        }
+        if (hi > cmax) {
+            cmax = hi;
+            xmax = x;
+        }
+    };
+
+    // Элементы уровня покрывают отсчёты до size() * width, остаток добирается уровнями ниже: на каждом
+    // из них это меньше Factor элементов
+    uint64_t pos = begin;
+    for (int l = level; l > 0; l--, width /= Factor) {
+        const auto &store = m_bins[l - 1];
+        const uint64_t cover = std::min(end, store.size() * width);
+        if (pos >= cover) {
+            continue;
+        }
+
+        const double half = (width - 1) / 2.0;
+        store.forEachSpan(pos / width, (cover - 1) / width + 1, [&](uint64_t index, const Bin *p, size_t n) {
+            for (size_t k = 0; k < n; k++) {
+                const uint64_t first = (index + k) * width;
+                add(std::max(first, begin), first + half, p[k].min, p[k].max);
+            }
+        });
+        pos = cover;
+    }
+
+    m_raw.forEachSpan(pos, end, [&](uint64_t index, const double *p, size_t n) {
+        for (size_t k = 0; k < n; k++) {
+            add(index + k, static_cast<double>(index + k), p[k], p[k]);
+        }
+    });
+    flush();
+}
@@ -0,0 +1,196 @@
+#ifndef SAMPLEPYRAMID_H
+#define SAMPLEPYRAMID_H
+
+#include <array>
+#include <deque>
+#include <QList>
+#include <QPointF>
+#include <QTemporaryFile>
+#include <vector>
+#include "spdlog/spdlog.h"
+
+/**
+ * @brief Хранилище по блокам фиксированного размера с вытеснением старых блоков во временный файл
+ *
+ * Дописывается только в конец. Вытесненный блок читается обратно при обращении, последний прочитанный блок
+ * держится в памяти.
+ */
+template <typename T>
+class SpillStore {
+public:
+    static constexpr size_t ChunkSize = (256 * 1024) / sizeof(T);    ///< Элементов в блоке
+    static constexpr size_t ChunkBytes = ChunkSize * sizeof(T);
+
+    void setFile(QFile *file) { m_file = file; }
+
+    void clear() {
+        m_chunks.clear();
+        m_size = 0;
+        m_firstInMemory = 0;
+        m_cacheChunk = SIZE_MAX;
+    }
+
+    void append(const T &value) {
+        if (m_size % ChunkSize == 0) {
+            m_chunks.emplace_back();
+            m_chunks.back().data.reserve(ChunkSize);
+        }
+        m_chunks.back().data.push_back(value);
+        m_size++;
+    }
+
+    uint64_t size() const { return m_size; }
+    size_t memoryBytes() const { return (m_chunks.size() - m_firstInMemory) * ChunkBytes; }
+
+    /**
+     * @brief Вытеснить самый старый заполненный блок из памяти в файл
+     * @return false, если вытеснять нечего или запись не удалась
+     */
+    bool spillOldest() {
+        if (m_file == nullptr || m_firstInMemory + 1 >= m_chunks.size()) {
+            return false;
+        }
+
+        auto &chunk = m_chunks[m_firstInMemory];
+        const qint64 offset = m_file->size();
+        if (!m_file->seek(offset) || m_file->write(reinterpret_cast<const char *>(chunk.data.data()), ChunkBytes) != ChunkBytes) {
+            return false;
+        }
+        chunk.offset = offset;
+        std::vector<T>().swap(chunk.data);
+        m_firstInMemory++;
+        return true;
+    }
+
+    /**
+     * @brief Освободить самый старый заполненный блок в памяти без записи в файл. Его элементы больше не читаются
+     * @return false, если освобождать нечего
+     */
+    bool dropOldest() {
+        if (m_firstInMemory + 1 >= m_chunks.size()) {
+            return false;
+        }
+
+        std::vector<T>().swap(m_chunks[m_firstInMemory].data);
+        m_chunks[m_firstInMemory].offset = Dropped;
+        m_firstInMemory++;
+        return true;
+    }
+
+    /**
+     * @brief Обойти элементы [begin, end) непрерывными участками. Отброшенные блоки пропускаются
+     * @param[in] func - вызывается как func(номер первого элемента участка, указатель, количество)
+     */
+    template <typename Func>
+    void forEachSpan(uint64_t begin, uint64_t end, Func &&func) const {
+        end = std::min(end, m_size);
+        while (begin < end) {
+            const size_t index = static_cast<size_t>(begin / ChunkSize);
+            const size_t pos = static_cast<size_t>(begin % ChunkSize);
+            const T *data = Chunk(index);
+            const size_t len = static_cast<size_t>(std::min<uint64_t>(end - begin, ChunkSize - pos));
+            if (data) {
+                func(begin, data + pos, len);
+            }
+            begin += len;
+        }
+    }
+
+private:
+    static constexpr qint64 InMemory = -1;
+    static constexpr qint64 Dropped = -2;
+
+    struct Block {
+        std::vector<T> data;
+        qint64 offset = InMemory;   ///< Смещение в файле вытесненного блока
+    };
+
+    QFile *m_file = nullptr;
+    std::deque<Block> m_chunks;
+    uint64_t m_size = 0;
+    size_t m_firstInMemory = 0;     ///< Блоки до этого номера вытеснены в файл
+
+    mutable std::vector<T> m_cache;
+    mutable size_t m_cacheChunk = SIZE_MAX;
+
+    const T *Chunk(size_t index) const {
+        const auto &chunk = m_chunks[index];
+        if (chunk.offset == InMemory) {
+            return chunk.data.data();
+        }
+        if (chunk.offset == Dropped) {
+            return nullptr;
+        }
+
+        if (m_cacheChunk != index) {
+            m_cache.resize(ChunkSize);
+            if (!m_file->seek(chunk.offset) || m_file->read(reinterpret_cast<char *>(m_cache.data()), ChunkBytes) != ChunkBytes) {
+                m_cacheChunk = SIZE_MAX;
+                return nullptr;
+            }
+            m_cacheChunk = index;
+        }
+        return m_cache.data();
+    }
+};
+
+
+/**
+ * @brief Пирамида min/max над потоком отсчётов для масштабирования и прокрутки всей истории
+ *
+ * Уровень 0 - исходные отсчёты, каждый элемент уровня k (k > 0) сводит Factor элементов уровня k - 1.
+ * Пирамида дополняется по мере поступления данных. Запрос выбирает уровень, на котором на столбец графика
+ * приходится не больше Factor элементов, поэтому стоимость отрисовки не зависит от длины окна.
+ *
+ * Память ограничена бюджетом: при превышении самые старые блоки нижних уровней вытесняются во временный файл.
+ * Файл ограничен SpillLimit: после его заполнения вытесняемые блоки отбрасываются, а не пишутся. Отброшенный
+ * участок виден только в масштабе, где его покрывают оставшиеся уровни, при сильном увеличении он пуст.
+ */
+class SamplePyramid {
+public:
+    static constexpr int Factor = 16;
+    static constexpr int Levels = 7;        ///< Уровень 6 - 16^6 отсчётов (~2.3 часа при 500 мкс) на элемент
+    static constexpr qint64 SpillLimit = 1024LL * 1024 * 1024;     ///< Наибольший размер файла вытеснения по умолчанию
+
+    struct Bin {
+        float min;
+        float max;
+    };
+
+    SamplePyramid();
+
+    void clear();
+    void append(const double *data, size_t count);
+
+    void setMemoryBudget(size_t bytes);
+    size_t memoryBudget() const { return m_budget; }
+    size_t memoryBytes() const;
+    void setSpillLimit(qint64 bytes) { m_spillLimit = bytes; }
+
+    /// Всего отсчётов с начала записи
+    uint64_t total() const { return m_raw.size(); }
+
+    void query(uint64_t begin, uint64_t end, int columns, double tick, QList<QPointF> &out) const;
+
+private:
+    struct Accumulator {
+        double min;
+        double max;
+        uint32_t count = 0;
+    };
+
+    QTemporaryFile m_spill;
+    SpillStore<double> m_raw;
+    std::array<SpillStore<Bin>, Levels - 1> m_bins;         ///< m_bins[k - 1] - уровень k
+    std::array<Accumulator, Levels - 1> m_pending;          ///< Незаконченный элемент каждого уровня
+    size_t m_budget = 64 * 1024 * 1024;
+    qint64 m_spillLimit = SpillLimit;
+    bool m_spillFull = false;               ///< Файл достиг m_spillLimit или недоступен, старые блоки отбрасываются
+
+    std::shared_ptr<spdlog::logger> logger;
+
+    void Push(int level, double min, double max);
+    void EnforceBudget();
+};
+
+#endif // SAMPLEPYRAMID_H
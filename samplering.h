@@ -0,0 +1,72 @@
+#ifndef SAMPLERING_H
+#define SAMPLERING_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Кольцевое хранилище отсчётов самописца
+ *
+ * Хранит только значения, время отсчёта вычисляется по его абсолютному номеру. Добавление блока из n отсчётов - O(n)
+ * независимо от заполненности. Абсолютный номер отсчёта растёт с начала записи и не сбрасывается при вытеснении.
+ */
+class SampleRing {
+public:
+    void reset(size_t capacity) {
+        m_buffer.assign(std::max<size_t>(capacity, 1), 0.0);
+        m_total = 0;
+    }
+
+    void clear() { m_total = 0; }
+
+    void append(const double *data, size_t count) {
+        // Из блока длиннее кольца нужен только хвост
+        if (count > capacity()) {
+            m_total += count - capacity();
+            data += count - capacity();
+            count = capacity();
+        }
+
+        size_t pos = m_total % capacity();
+        const size_t first = std::min(count, capacity() - pos);
+        std::copy(data, data + first, m_buffer.begin() + pos);
+        std::copy(data + first, data + count, m_buffer.begin());
+        m_total += count;
+    }
+
+    size_t capacity() const { return m_buffer.size(); }
+    size_t size() const { return static_cast<size_t>(std::min<uint64_t>(m_total, capacity())); }
+    bool isEmpty() const { return m_total == 0; }
+
+    /// Номер следующего отсчёта (всего добавлено отсчётов)
+    uint64_t total() const { return m_total; }
+    /// Номер самого старого хранимого отсчёта
+    uint64_t first() const { return m_total - size(); }
+
+    /// Отсчёт по абсолютному номеру, first() <= index < total()
+    double at(uint64_t index) const { return m_buffer[index % capacity()]; }
+
+    /**
+     * @brief Обойти отсчёты [begin, end) непрерывными участками памяти
+     * @param[in] func - вызывается как func(номер первого отсчёта участка, указатель, количество)
+     */
+    template <typename Func>
+    void forEachSpan(uint64_t begin, uint64_t end, Func &&func) const {
+        begin = std::max(begin, first());
+        end = std::min(end, m_total);
+        while (begin < end) {
+            const size_t pos = begin % capacity();
+            const size_t len = static_cast<size_t>(std::min<uint64_t>(end - begin, capacity() - pos));
+            func(begin, m_buffer.data() + pos, len);
+            begin += len;
+        }
+    }
+
+private:
+    std::vector<double> m_buffer = std::vector<double>(1, 0.0);
+    uint64_t m_total = 0;
+};
+
+#endif // SAMPLERING_H
@@ -5,6 +5,14 @@
 
 #define SIMULATOR_CURRENT_COUNTER   (40)    ///< 40 измерений тока
 
+namespace {
+/// Порт симулятора: передача уходит в никуда, команды завершаются по таймауту
+struct NullPort {
+    qint64 write(const QByteArray &data) { return data.size(); }
+    qint64 bytesAvailable() const { return 0; }
+};
+}
+
 
 SerialPortWorker::SerialPortWorker(bool isSimulator, QObject *parent) : m_isSimulator(isSimulator), QThread(parent) {
     logger = spdlog::get("Serial");
@@ -22,7 +30,19 @@ SerialPortWorker::~SerialPortWorker() {
     m_mutex.lock();
     m_quit = true;
     m_mutex.unlock();
+    WakeTransport();
     wait();
+    DetachFromBus();
+
+    // Узлы, не отключённые до удаления линии, остаются без линии и отклоняют команды
+    m_nodesLock.lock();
+    for (auto node : m_nodes) {
+        node->m_mutex.lock();
+        node->m_bus = nullptr;
+        node->m_mutex.unlock();
+    }
+    m_nodes.clear();
+    m_nodesLock.unlock();
     logger->info("Shutdown successfully");
 }
 
@@ -36,11 +56,22 @@ const QMutexLocker locker(&m_mutex);
 }
 
 void SerialPortWorker::run() {
+    m_clock.start();
+    m_frameTracker.reset();
+    {
+        const QMutexLocker locker(&m_frameStatsLock);
+        m_frameStats = FrameCounterTracker::Stats();
+    }
     if (m_isSimulator) {
         runSimulator();
+#ifdef __linux__
+    } else if (m_transport == Transport::NativeTty) {
+        runTty();
+#endif
     } else {
         runSerial();
     }
+    AbortRequests();
 }
 
 void SerialPortWorker::runSimulator() {
@@ -48,18 +79,34 @@ void SerialPortWorker::runSimulator() {
     
     size_t itable = 0;
     size_t itable_temperature = 128;
-QList<double> current(40);
+TelemetryRecord record{};
+NullPort port;
     while (!m_quit) {
         QThread::msleep(20);
+        ServiceCommand(port);
         for (int i = 0; i < 40; i++) {
-            current[i] = m_phaseTable[itable];
+            record.frame.current[i] = static_cast<int16_t>(m_phaseTable[itable] * 1000.0);
             itable = (itable + 1) & SinTableModMask;
         }
 
-        double temperature = m_phaseTable[itable_temperature];
+        record.frame.temperature = static_cast<float>(m_phaseTable[itable_temperature]);
         itable_temperature = (itable_temperature + 1) & SinTableModMask;
 
-        emit telemetryRecv(current, temperature, 0, 0);
+        record.frame.counter++;
+        record.timestamp = m_clock.nsecsElapsed() / 1000;
+
+        m_nodesLock.lock();
+        const bool bus = !m_nodes.isEmpty();
+        for (auto node : m_nodes) {
+            // Узлы шины различаются смещением температуры на адрес
+            TelemetryRecord nodeRecord = record;
+            nodeRecord.frame.temperature += node->m_address;
+            node->PushTelemetry(nodeRecord);
+        }
+        m_nodesLock.unlock();
+        if (!bus) {
+            PushTelemetry(record);
+        }
     }
 }
 
@@ -79,8 +126,7 @@ void SerialPortWorker::runSerial() {
 
     Wake wake;
     QSerialPort serial;
-    QByteArray recvData;
-    QDeadlineTimer dealineTimer;
+    ByteRingBuffer recvRing(ReadBufferSize);
 
     connect(&serial, &QSerialPort::errorOccurred, [this, &serial](QSerialPort::SerialPortError err) {
         switch (err) {
@@ -102,12 +148,12 @@ void SerialPortWorker::runSerial() {
             emit error("Port not set");
             return;
         } else if (currentPortNameChanged) {
-            recvData.clear();
+            recvRing.clear();
 
             serial.close();
             serial.setPortName(currentPortName);
             serial.setBaudRate(921600);
-            serial.setReadBufferSize(1024 * 1024);
+            serial.setReadBufferSize(ReadBufferSize);
             if (!serial.open(QIODevice::ReadWrite)) {
                 QString err = QString("Cannot open %1, error code %2").arg(currentPortName).arg(serial.error());
                 logger->error(err.toStdString());
@@ -117,33 +163,13 @@ void SerialPortWorker::runSerial() {
         }
 
         if (serial.waitForReadyRead(currentWaitTimeout)) {
-            recvData += serial.readAll();
-            while (serial.waitForReadyRead(2)) {
-                recvData += serial.readAll();
+            ReadToRing(serial, recvRing);
+            while (recvRing.free() > 0 && serial.waitForReadyRead(2)) {
+                ReadToRing(serial, recvRing);
             }
         }
 
-        while (!recvData.isEmpty()) {
-            auto b = (uint8_t)recvData[0];
-            recvData.removeAt(0);
-            if (wake.ProcessInByte(b) == Wake::Status::READY) {
-                if (wake.command() != qToUnderlying(tec::Commands::Telemetry)) {
-                    logger->info("Received Wake {}. Remain {} bytes", wake.command(), recvData.size());
-                    
-                    m_mutex.lock();
-                    if (m_commandPending == wake.command()) {
-                        m_commandPending = qToUnderlying(tec::Commands::Invalid);
-                        emit commandExecute(CommandError::NoError, static_cast<tec::Commands>(wake.command()), wake.dataArray());
-                    }
-                    m_mutex.unlock();
-                }
-
-                if (wake.command() == qToUnderlying(tec::Commands::Telemetry)) {
-                    ParseTelemetryRecord(wake.data());
-                }
-                break;
-            }
-        }
+        DecodeRing(wake, recvRing, serial);
 
         m_mutex.lock();
         if (currentPortName != m_portName) {
@@ -153,150 +179,696 @@ void SerialPortWorker::runSerial() {
             currentPortNameChanged = false;
         }
         currentWaitTimeout = m_waitTimeout;
+        m_mutex.unlock();
+
+        ServiceCommand(serial);
+    }
+}
+
+#ifdef __linux__
+/**
+ * @brief Приём через termios и epoll, без опроса waitForReadyRead
+ * 
+ * Поток спит в epoll до прихода данных или до запроса на передачу/выход (TtyPort::wake()).
+ * Таймаут ожидания задаётся ближайшим сроком ответа на команды в полёте.
+ */
+void SerialPortWorker::runTty() {
+    logger->info("Using native tty transport");
 
-        if (m_txDataPending.size() > 0) {
-            logger->info("Transmit");
-            serial.write(m_txDataPending);
-            m_txDataPending.clear();
-            dealineTimer.setRemainingTime(m_commandTimeout);
+    m_mutex.lock();
+    QString portName = m_portName;
+    m_mutex.unlock();
+
+    if (portName.isEmpty()) {
+        logger->error("Serial port name must be defined");
+        emit error("Port not set");
+        return;
+    }
+
+    TtyPort tty;
+    if (!tty.open(portName, 921600)) {
+        QString err = QString("Cannot open %1: %2").arg(portName).arg(tty.errorString());
+        logger->error(err.toStdString());
+        emit error(err);
+        return;
+    }
+
+    m_mutex.lock();
+    m_tty = &tty;
+    m_mutex.unlock();
+
+    Wake wake;
+    ByteRingBuffer recvRing(ReadBufferSize);
+
+    while (!m_quit) {
+        int timeout = static_cast<int>(NextTimeout());
+        int events = tty.wait(timeout);
+        if (events & TtyPort::Error) {
+            QString err = QString("Serial port error occurred ('%1')").arg(tty.errorString());
+            logger->error(err.toStdString());
+            emit error(err);
+            break;
         }
 
-        if (m_commandPending != qToUnderlying(tec::Commands::Invalid) && dealineTimer.hasExpired()) {
-            logger->warn("Command: {} timeout", m_commandPending);
-            emit commandExecute(CommandError::TimeoutError, static_cast<tec::Commands>(m_commandPending), QByteArray());
-            m_commandPending = qToUnderlying(tec::Commands::Invalid);
+        if (events & TtyPort::Readable) {
+            ReadToRing(tty, recvRing);
+        }
+
+        DecodeRing(wake, recvRing, tty);
+        ServiceCommand(tty);
+    }
+
+    m_mutex.lock();
+    m_tty = nullptr;
+    m_mutex.unlock();
+}
+
+void SerialPortWorker::ReadToRing(TtyPort &tty, ByteRingBuffer &ring) {
+    while (ring.free() > 0) {
+        auto span = ring.writeSpan();
+        auto n = tty.read(span.data(), span.size());
+        if (n <= 0) {
+            break;
+        }
+        ring.commit(n);
+    }
+}
+#endif
+
+/**
+ * @brief Разбудить поток приёма, если он спит в ожидании (только для TtyPort)
+ */
+void SerialPortWorker::WakeTransport() {
+#ifdef __linux__
+    m_mutex.lock();
+    if (m_tty) {
+        m_tty->wake();
+    }
+    auto bus = m_bus;
+    m_mutex.unlock();
+
+    // Узел шины порт не открывает, будим поток линии
+    if (bus) {
+        bus->WakeTransport();
+    }
+#endif
+}
+
+/**
+ * @brief Обработать принятый кадр: телеметрия или ответ на команду в полёте
+ */
+void SerialPortWorker::HandleFrame(const Wake::Frame &frame) {
+    m_nodesLock.lock();
+    if (!m_nodes.isEmpty()) {
+        RouteFrame(frame);
+        m_nodesLock.unlock();
+        return;
+    }
+    m_nodesLock.unlock();
+
+    if (frame.command == qToUnderlying(tec::Commands::Telemetry)) {
+        // Узел шины присылает телеметрию в ответ на опрос
+        m_mutex.lock();
+        if (m_bus) {
+            CommandRequest poll;
+            m_commands.complete(frame.command, -1, poll);
         }
         m_mutex.unlock();
+        ParseTelemetryRecord(frame.data);
+        return;
     }
+
+    logger->info("Received Wake {}", frame.command);
+const int key = frame.data.empty() ? -1 : frame.data[0];
+CommandRequest request;
+    m_mutex.lock();
+    const bool expected = m_commands.complete(frame.command, key, request);
+    m_mutex.unlock();
+
+    if (!expected) {
+        logger->warn("Unexpected reply {}, size {}", frame.command, frame.data.size());
+        return;
+    }
+
+    QByteArray data(reinterpret_cast<const char *>(frame.data.data()), frame.data.size());
+    UpdateCache(request, data);
+    FinishRequest(request, CommandError::NoError, data);
+}
+
+/**
+ * @brief Разобрать всё накопленное в кольцевом буфере порциями DecodeSliceSize
+ * 
+ * Между порциями обслуживается передача и таймауты, чтобы команда не ждала разбора всего хвоста
+ */
+template <typename Port>
+void SerialPortWorker::DecodeRing(Wake &wake, ByteRingBuffer &ring, Port &port) {
+    // Всё, что накопилось к этому проходу: в кольцевом буфере и в буфере порта
+    const qint64 backlogBytes = static_cast<qint64>(ring.size()) + port.bytesAvailable();
+    const auto backlogFrames = static_cast<qint64>(wake.processRing(ring, DecodeSliceSize,
+        [this](const Wake::Frame &frame) { HandleFrame(frame); },
+        [this, &port]() { ServiceCommand(port); }));
+    UpdateBacklog(backlogBytes, backlogFrames);
 }
 
+/**
+ * @brief Проверить таймауты команд в полёте и передать ожидающие, пока есть место в окне
+ *
+ * Истёкшая команда с оставшимися повторами передаётся заново раньше остальных ожидающих.
+ */
+template <typename Port>
+void SerialPortWorker::ServiceCommand(Port &port) {
+    m_nodesLock.lock();
+    if (!m_nodes.isEmpty()) {
+        ServiceBus(port);
+        m_nodesLock.unlock();
+        return;
+    }
+    m_nodesLock.unlock();
 
-void SerialPortWorker::commandTransmit(tec::Commands cmd, const QByteArray &tx) {
-    if (m_mutex.tryLock(100)) {
-        m_commandPending = qToUnderlying(cmd);
-        m_txDataPending = tx;
+QList<CommandRequest> failed;
+    m_mutex.lock();
+    if (!m_commands.hasWork()) {
         m_mutex.unlock();
+        return;
+    }
+
+    m_commands.expire([&failed](CommandRequest &&request) {
+        failed.append(std::move(request));
+    });
+    m_commands.transmit([this, &port](const CommandRequest &request) {
+        if (request.attempts > 1) {
+            logger->warn("Command {} (request {}) retransmit {}", request.command, request.id, request.attempts - 1);
+        } else {
+            logger->debug("Transmit command {} (request {})", request.command, request.id);
+        }
+        port.write(request.tx);
+    });
+    m_commandTimeouts += failed.size();
+    m_mutex.unlock();
+
+    for (const auto &request : failed) {
+        logger->warn("Command {} (request {}) timeout after {} attempts", request.command, request.id, request.attempts);
+        FinishRequest(request, CommandError::TimeoutError);
+    }
+}
+
+/**
+ * @brief Обслужить узлы шины. Вызывать под m_nodesLock
+ *
+ * Ответы узлов делят одну линию, поэтому в полёте могут быть команды только одного узла: он может досылать
+ * свои команды в пределах окна. Когда линия свободна, узлы по кругу получают право передать свои команды
+ * или, если команд нет, опрос телеметрии.
+ */
+template <typename Port>
+void SerialPortWorker::ServiceBus(Port &port) {
+SerialPortWorker *owner = nullptr;
+    for (auto node : std::as_const(m_nodes)) {
+        if (node->ServiceNode(port, false)) {
+            owner = node;
+        }
+    }
+    if (owner) {
+        owner->ServiceNode(port, true);
+        return;
+    }
+
+const auto count = m_nodes.size();
+    for (qsizetype i = 0; i < count; i++) {
+        const auto index = (m_nextNode + i) % count;
+        if (m_nodes[index]->ServiceNode(port, true)) {
+            m_nextNode = (index + 1) % count;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Таймауты и передача команд узла шины. Вызывается потоком линии
+ * @param[in] port - порт линии
+ * @param[in] transmit - линия свободна или занята этим же узлом, можно передавать
+ * @return У узла есть команды в полёте
+ */
+template <typename Port>
+bool SerialPortWorker::ServiceNode(Port &port, bool transmit) {
+QList<CommandRequest> failed;
+    m_mutex.lock();
+    m_commands.expire([&failed](CommandRequest &&request) {
+        failed.append(std::move(request));
+    });
+
+    const qint64 now = m_clock.elapsed();
+    if (transmit && m_commands.inFlight() == 0 && m_commands.pending() == 0 && !m_pollFrame.isEmpty() &&
+        (m_lastPoll < 0 || now - m_lastPoll >= PollInterval)) {
+        // Опрос телеметрии - внутренний запрос без номера, о нём никто не уведомляется
+        CommandRequest poll;
+        poll.id = 0;
+        poll.command = qToUnderlying(tec::Commands::Telemetry);
+        poll.tx = m_pollFrame;
+        poll.timeout = PollTimeout;
+        poll.retries = 0;
+        m_commands.enqueue(std::move(poll));
+        m_lastPoll = now;
+    }
+
+    if (transmit) {
+        m_commands.transmit([this, &port](const CommandRequest &request) {
+            if (request.id != 0) {
+                logger->debug("Transmit command {} (request {}) to node {}", request.command, request.id, m_address);
+            }
+            port.write(request.tx);
+        });
+    }
+
+    for (const auto &request : failed) {
+        if (request.id == 0) {
+            m_pollTimeouts++;
+        } else {
+            m_commandTimeouts++;
+        }
+    }
+    const bool inFlight = m_commands.inFlight() > 0;
+    m_mutex.unlock();
+
+    for (const auto &request : failed) {
+        if (request.id != 0) {
+            logger->warn("Command {} (request {}) to node {} timeout after {} attempts", request.command, request.id, m_address, request.attempts);
+            FinishRequest(request, CommandError::TimeoutError);
+        }
+    }
+    return inFlight;
+}
+
+/**
+ * @brief Передать принятый кадр узлу шины по адресу отправителя. Вызывать под m_nodesLock
+ *
+ * Кадр без адреса отдаётся узлу, команды которого сейчас в полёте.
+ */
+void SerialPortWorker::RouteFrame(const Wake::Frame &frame) {
+    for (auto node : std::as_const(m_nodes)) {
+        bool match = node->m_address == frame.address;
+        if (frame.address == Wake::NoAddress) {
+            node->m_mutex.lock();
+            match = node->m_commands.inFlight() > 0;
+            node->m_mutex.unlock();
+        }
+        if (match) {
+            node->HandleFrame(frame);
+            return;
+        }
+    }
+    logger->warn("Frame {} from unknown node {}", frame.command, frame.address);
+}
+
+/**
+ * @brief Сколько поток порта может ждать данных: до ближайшего таймаута, передачи или опроса узла
+ * @return мс, -1 - без ограничения
+ */
+qint64 SerialPortWorker::NextTimeout() {
+const QMutexLocker nodesLocker(&m_nodesLock);
+    if (m_nodes.isEmpty()) {
+        const QMutexLocker locker(&m_mutex);
+        return m_commands.nextTimeout();
     }
+
+qint64 ready = -1;      // Ближайшее событие узлов, которым нужна свободная линия
+qint64 busy = -1;       // Ближайший таймаут команд в полёте
+    auto earliest = [](qint64 a, qint64 b) { return a < 0 ? b : b < 0 ? a : std::min(a, b); };
+    for (auto node : std::as_const(m_nodes)) {
+        const QMutexLocker locker(&node->m_mutex);
+        if (node->m_commands.inFlight() > 0) {
+            busy = earliest(busy, node->m_commands.nextTimeout());
+        } else if (node->m_commands.pending() > 0) {
+            ready = 0;
+        } else if (!node->m_pollFrame.isEmpty()) {
+            const qint64 since = node->m_lastPoll < 0 ? PollInterval : node->m_clock.elapsed() - node->m_lastPoll;
+            ready = earliest(ready, std::max<qint64>(0, PollInterval - since));
+        }
+    }
+    return busy >= 0 ? busy : ready;
+}
+
+/**
+ * @brief Работать узлом шины RS-485: команды уходят через поток линии с адресом узла, телеметрия опрашивается
+ * @param[in] link - поток, который ведёт линию (startReceiver() уже вызван). Должен жить дольше узла
+ * @param[in] address - адрес контроллера на линии, 1..127
+ */
+void SerialPortWorker::attachToBus(SerialPortWorker *link, uint8_t address) {
+    m_mutex.lock();
+    m_bus = link;
+    m_address = address & 0x7F;
+    m_quit = false;
+    m_mutex.unlock();
+
+    m_clock.start();
+    m_frameTracker.reset();
+    {
+        const QMutexLocker locker(&m_frameStatsLock);
+        m_frameStats = FrameCounterTracker::Stats();
+    }
+    m_lastPoll = -1;
+    // Симулятор телеметрию не опрашивает, а раздаёт узлам сам
+    m_pollFrame = link->m_isSimulator ? QByteArray() : Wake::PrepareTx(qToUnderlying(tec::Commands::Telemetry), QByteArray(), m_address);
+
+    link->AddNode(this);
+    logger->info("Bus node {} attached", m_address);
+}
+
+int SerialPortWorker::address() const {
+const QMutexLocker locker(&m_mutex);
+    return m_address;
+}
+
+void SerialPortWorker::AddNode(SerialPortWorker *node) {
+const QMutexLocker locker(&m_nodesLock);
+    m_nodes.append(node);
+}
+
+void SerialPortWorker::RemoveNode(SerialPortWorker *node) {
+const QMutexLocker locker(&m_nodesLock);
+    m_nodes.removeOne(node);
+    if (m_nextNode >= m_nodes.size()) {
+        m_nextNode = 0;
+    }
+}
+
+/**
+ * @brief Отключиться от линии. После возврата поток линии узел не вызывает, команды в очереди отклонены
+ */
+void SerialPortWorker::DetachFromBus() {
+    if (m_address == Wake::NoAddress) {
+        return;
+    }
+
+    m_mutex.lock();
+    auto bus = m_bus;
+    m_mutex.unlock();
+    if (bus) {
+        bus->RemoveNode(this);
+        m_mutex.lock();
+        m_bus = nullptr;
+        m_mutex.unlock();
+    }
+    // Линия могла быть удалена раньше узла, очередь всё равно отклоняется
+    AbortRequests();
+    logger->info("Bus node {} detached", m_address);
+}
+
+/**
+ * @brief Обновить счётчики очереди приёма
+ * @param[in] bytes - байт, ожидавших разбора в начале прохода
+ * @param[in] frames - кадров, разобранных из них за проход
+ */
+void SerialPortWorker::UpdateBacklog(qint64 bytes, qint64 frames) {
+    m_backlogBytes = bytes;
+    m_backlogFrames = frames;
+    if (bytes > m_backlogBytesMax) {
+        m_backlogBytesMax = bytes;
+    }
+    if (frames > m_backlogFramesMax) {
+        m_backlogFramesMax = frames;
+    }
+}
+
+SerialPortWorker::Backlog SerialPortWorker::backlog() const {
+    return Backlog{m_backlogBytes, m_backlogFrames, m_backlogBytesMax, m_backlogFramesMax};
+}
+
+/**
+ * @brief Прочитать всё доступное из порта прямо в кольцевой буфер, без промежуточных QByteArray
+ * 
+ * Если буфер заполнен, остаток ждёт во внутреннем буфере QSerialPort до следующего прохода
+ */
+void SerialPortWorker::ReadToRing(QSerialPort &serial, ByteRingBuffer &ring) {
+    while (serial.bytesAvailable() > 0 && ring.free() > 0) {
+        auto span = ring.writeSpan();
+        auto n = serial.read(reinterpret_cast<char *>(span.data()), span.size());
+        if (n <= 0) {
+            break;
+        }
+        ring.commit(n);
+    }
+}
+
+
+/**
+ * @brief Поставить команду в очередь передачи
+ * @param[in] cmd - команда
+ * @param[in] payload - данные команды без обрамления Wake
+ * @param[in] callback - вызывается один раз по завершении запроса, в потоке context (или GUI, если context не задан)
+ * @param[in] context - получатель callback; если он удалён до ответа, callback не вызывается
+ * @param[in] timeoutMs - ожидание ответа на одну передачу, -1 - setCommandTimeout()
+ * @param[in] retries - повторов при таймауте, -1 - setCommandRetries()
+ * @return номер запроса, он же приходит в requestFinished()
+ */
+SerialPortWorker::RequestId SerialPortWorker::request(tec::Commands cmd, const QByteArray &payload, CommandCallback callback,
+                                                      QObject *context, qint64 timeoutMs, int retries) {
+std::array<uint8_t, Wake::TxSizeMaximum(Wake::PayloadMaximum)> frame;
+const std::span<const uint8_t> data(reinterpret_cast<const uint8_t *>(payload.constData()), payload.size());
+    const size_t size = Wake::Encode(frame, qToUnderlying(cmd), data);
+    if (size == 0) {
+        logger->error("Command {}: payload of {} bytes does not fit a frame", qToUnderlying(cmd), payload.size());
+    }
+    return Submit(cmd, data, std::span<const uint8_t>(frame.data(), size), std::move(callback), context, timeoutMs, retries);
+}
+
+/**
+ * @brief Поставить в очередь готовый кадр
+ * @param[in] cmd - команда
+ * @param[in] payload - данные команды без обрамления, по ним определяются ключ ответа и параметр кэша
+ * @param[in] frame - кадр Wake, пустой - запрос сразу завершается с Error
+ */
+SerialPortWorker::RequestId SerialPortWorker::Submit(tec::Commands cmd, std::span<const uint8_t> payload, std::span<const uint8_t> frame,
+                                                     CommandCallback callback, QObject *context, qint64 timeoutMs, int retries) {
+CommandRequest request;
+    request.command = qToUnderlying(cmd);
+    request.payload = QByteArray(reinterpret_cast<const char *>(payload.data()), payload.size());
+    // Ответ на команды PID повторяет тип переменной, по нему различаются одновременные запросы
+    request.key = tecdesc::Registry::replyKey(cmd, payload);
+
+    m_nodesLock.lock();
+    const bool isLink = !m_nodes.isEmpty();
+    m_nodesLock.unlock();
+
+    m_mutex.lock();
+    // Линия шины сама команд не передаёт, только её узлы
+    const bool running = (isRunning() || m_bus) && !isLink && !m_quit && !frame.empty();
+    const int address = m_address;
+    request.id = m_nextRequestId++;
+    request.timeout = timeoutMs >= 0 ? timeoutMs : m_commandTimeout;
+    request.retries = retries >= 0 ? retries : m_commandRetries;
+    if (callback) {
+        m_callbacks.emplace(request.id, RequestCallback{std::move(callback), context, context != nullptr});
+    }
+    const RequestId id = request.id;
+    const auto cache = m_cache;
+    const qint64 cacheMaxAge = m_cacheMaxAge;
+    m_mutex.unlock();
+
+    if (address != Wake::NoAddress && !frame.empty()) {
+        // Узел шины: тот же кадр, но с адресом контроллера
+        std::array<uint8_t, Wake::TxSizeMaximum(Wake::PayloadMaximum)> addressed;
+        const size_t size = Wake::Encode(addressed, qToUnderlying(cmd), payload, address);
+        request.tx = QByteArray(reinterpret_cast<const char *>(addressed.data()), size);
+    } else {
+        request.tx = QByteArray(reinterpret_cast<const char *>(frame.data()), frame.size());
+    }
+
+    // Свежее подтверждённое значение выдаётся из кэша, без обращения к линии
+const auto access = cache && running ? ParameterCache::access(cmd, request.payload) : std::nullopt;
+    if (access && !access->write) {
+        QByteArray cached;
+        if (cache->lookup(access->key, cacheMaxAge, cached)) {
+            logger->debug("Command {} (request {}) served from cache", qToUnderlying(cmd), id);
+            FinishRequest(request, CommandError::NoError, cached);
+            return id;
+        }
+    } else if (access) {
+        cache->markDirty(access->key);
+    }
+
+    m_mutex.lock();
+    const bool queued = running && m_commands.enqueue(std::move(request));
+    m_mutex.unlock();
+
+    if (!queued) {
+        logger->error("Command {} (request {}) rejected: {}", qToUnderlying(cmd), id, running ? "queue is full" : isLink ? "bus link" : frame.empty() ? "no frame" : "port closed");
+        CommandRequest rejected;
+        rejected.id = id;
+        rejected.command = qToUnderlying(cmd);
+        FinishRequest(rejected, CommandError::Error);
+        return id;
+    }
+
     emit commandExecute(CommandError::Busy, cmd, QByteArray());
+    WakeTransport();
+    return id;
+}
+
+/**
+ * @brief Запомнить подтверждённое контроллером значение
+ *
+ * Ответ на чтение хранится как есть. Ответ на запись - если он в том же формате, иначе записанные данные.
+ */
+void SerialPortWorker::UpdateCache(const CommandRequest &request, const QByteArray &reply) {
+    m_mutex.lock();
+    const auto cache = m_cache;
+    m_mutex.unlock();
+
+const auto access = cache ? ParameterCache::access(static_cast<tec::Commands>(request.command), request.payload) : std::nullopt;
+    if (!access) {
+        return;
+    }
+
+    if (!access->write || reply.size() == request.payload.size()) {
+        cache->confirm(access->key, reply);
+    } else {
+        cache->confirm(access->key, request.payload);
+    }
+}
+
+/**
+ * @brief Сообщить о завершении запроса: сигналы и callback. Вызывать без m_mutex
+ */
+void SerialPortWorker::FinishRequest(const CommandRequest &request, CommandError error, const QByteArray &data) {
+const auto cmd = static_cast<tec::Commands>(request.command);
+RequestCallback callback;
+bool hasCallback = false;
+    m_mutex.lock();
+    auto it = m_callbacks.find(request.id);
+    if (it != m_callbacks.end()) {
+        callback = std::move(it->second);
+        hasCallback = true;
+        m_callbacks.erase(it);
+    }
+    m_mutex.unlock();
+
+    emit requestFinished(request.id, error, cmd, data);
+    emit commandExecute(error, cmd, data);
+
+    if (!hasCallback) {
+        return;
+    }
+
+    QObject *context = callback.hasContext ? callback.context.data() : this;
+    if (context == nullptr) {
+        return;
+    }
+    QMetaObject::invokeMethod(context, [cb = std::move(callback.callback), error, data]() {
+        cb(error, data);
+    }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Отказ всем командам в очереди при остановке потока
+ */
+void SerialPortWorker::AbortRequests() {
+QList<CommandRequest> aborted;
+    m_mutex.lock();
+    m_commands.clear([&aborted](CommandRequest &&request) {
+        aborted.append(std::move(request));
+    });
+    m_mutex.unlock();
+
+    for (const auto &request : aborted) {
+        FinishRequest(request, CommandError::Error);
+    }
+}
+
+void SerialPortWorker::setCommandWindow(int window) {
+const QMutexLocker locker(&m_mutex);
+    m_commands.setWindow(static_cast<size_t>(std::max(window, 1)));
+}
+
+/**
+ * @brief Подключить кэш параметров. Один кэш передаётся всем потокам одного порта
+ * @param[in] cache - кэш, nullptr - без кэша
+ * @param[in] maxAgeMs - чтение старше этого срока идёт в контроллер
+ */
+void SerialPortWorker::setParameterCache(std::shared_ptr<ParameterCache> cache, qint64 maxAgeMs) {
+const QMutexLocker locker(&m_mutex);
+    m_cache = std::move(cache);
+    m_cacheMaxAge = maxAgeMs;
 }
 
-void SerialPortWorker::commandTransmit(tec::Commands cmd) {
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), QByteArray()));
+SerialPortWorker::CommandStats SerialPortWorker::commandStats() const {
+const QMutexLocker locker(&m_mutex);
+    return CommandStats{m_commands.inFlight(), m_commands.pending(), m_commands.retransmits(), m_commandTimeouts, m_pollTimeouts};
 }
 
 
 void SerialPortWorker::setOutputVoltage(double voltagePercent) {
-float v = static_cast<float>(voltagePercent);
-auto cmd = tec::Commands::VoltageGetSet;
-QByteArray arr;
-    arr.append(reinterpret_cast<const char *>(&v), 4);
-    arr = Wake::PrepareTx(qToUnderlying(cmd), arr);
-    commandTransmit(cmd, arr);    
+    Submit<tecdesc::OutputVoltage>(tecdesc::OutputVoltage::write(voltagePercent));
 }
 
 void SerialPortWorker::getOutputVoltage() {
-auto cmd = tec::Commands::VoltageGetSet;
-    auto arr = Wake::PrepareTx(qToUnderlying(cmd), QByteArray());
-    commandTransmit(cmd, arr);
+    Submit<tecdesc::OutputVoltage>(tecdesc::OutputVoltage::read());
 }
 
 void SerialPortWorker::setCurrentPid(PidVariableType type, double value) {
-auto cmd = tec::Commands::CurrentPidGetSet;
-float v = static_cast<float>(value);
-QByteArray arr;
-    arr.append(qToUnderlying(type));
-    arr.append(reinterpret_cast<const char *>(&v), 4);
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), arr));
+    Submit<tecdesc::CurrentPid>(tecdesc::CurrentPid::write(type, value));
 }
 
 void SerialPortWorker::getCurrentPid(PidVariableType type) {
-auto cmd = tec::Commands::CurrentPidGetSet;
-QByteArray arr;
-    arr.append(qToUnderlying(type));
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), arr));
+    Submit<tecdesc::CurrentPid>(tecdesc::CurrentPid::read(type));
 }
 
 void SerialPortWorker::setTemperaturePid(PidVariableType type, double value) {
-auto cmd = tec::Commands::TemperaturePidGetSet;
-float v = static_cast<float>(value);
-QByteArray arr;
-    arr.append(qToUnderlying(type));
-    arr.append(reinterpret_cast<const char *>(&v), 4);
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), arr));
+    Submit<tecdesc::TemperaturePid>(tecdesc::TemperaturePid::write(type, value));
 }
 
 void SerialPortWorker::getTemperaturePid(PidVariableType type) {
-auto cmd = tec::Commands::TemperaturePidGetSet;
-QByteArray arr;
-    arr.append(qToUnderlying(type));
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), arr));
+    Submit<tecdesc::TemperaturePid>(tecdesc::TemperaturePid::read(type));
 }
 
 void SerialPortWorker::setTemperature(double value) {
-auto cmd = tec::Commands::TemperatureStabGetSet;
-float v = static_cast<float>(value);
-QByteArray arr;
-    arr.append(reinterpret_cast<const char *>(&v), 4);
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), arr));
+    Submit<tecdesc::TemperatureSetpoint>(tecdesc::TemperatureSetpoint::write(value));
 }
 
 void SerialPortWorker::getTemperature() {
-auto cmd = tec::Commands::TemperatureStabGetSet;
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), QByteArray()));
+    Submit<tecdesc::TemperatureSetpoint>(tecdesc::TemperatureSetpoint::read());
 }
 
 void SerialPortWorker::setWorkMode(WorkMode mode) {
-auto cmd = tec::Commands::WorkModeSetGet;
-QByteArray arr;
-    arr.append(qToUnderlying(mode));
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), arr));
+    Submit<tecdesc::Mode>(tecdesc::Mode::write(mode));
 }
 
 void SerialPortWorker::getWorkMode() {
-auto cmd = tec::Commands::WorkModeSetGet;
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), QByteArray()));
+    Submit<tecdesc::Mode>(tecdesc::Mode::read());
 }
 
 void SerialPortWorker::setDebugCurrent(double value) {
-auto cmd = tec::Commands::CurrentStabGetSet;
-float v = static_cast<float>(value);
-QByteArray arr;
-    arr.append(reinterpret_cast<const char *>(&v), 4);
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), arr));
+    Submit<tecdesc::DebugCurrent>(tecdesc::DebugCurrent::write(value));
 }
 
 void SerialPortWorker::getDebugCurrent() {
-auto cmd = tec::Commands::CurrentStabGetSet;
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), QByteArray()));
+    Submit<tecdesc::DebugCurrent>(tecdesc::DebugCurrent::read());
 }
 
 void SerialPortWorker::getVersion() {
-auto cmd = tec::Commands::VersionGet;
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), QByteArray()));
+    Submit<tecdesc::Version>(tecdesc::Version::read());
 }
 
 void SerialPortWorker::setSecurityKey(const QByteArray &key) {
-auto cmd = tec::Commands::KeyGetSet;
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), key));
+    request(tec::Commands::KeyGetSet, key);
 }
 
 void SerialPortWorker::getSecurityKey() {
-    commandTransmit(tec::Commands::KeyGetSet);
+    request(tec::Commands::KeyGetSet, QByteArray());
 }
 
 void SerialPortWorker::saveSettingsToEeprom() {
-    commandTransmit(tec::Commands::Save);
+    Submit<tecdesc::Save>(tecdesc::Save::read());
 }
 
 void SerialPortWorker::sendFrame(tec::Commands cmd, const QByteArray &data) {
-    commandTransmit(cmd, Wake::PrepareTx(qToUnderlying(cmd), data));
+    request(cmd, data);
 }
 
 void SerialPortWorker::recvValid(const QList<uint8_t> &data, uint8_t command) {
 QByteArray a((const char *)data.constData(), data.size());
     logger->trace("Recv valid command {}, size {}: {}", command, data.size(), a.toHex(':').toStdString());
     if (command == 0x55) {
-        ParseTelemetryRecord(data);
+        ParseTelemetryRecord(std::span<const uint8_t>(data.constData(), data.size()));
     }
 }
 
@@ -310,29 +882,57 @@ QByteArray a((const char *)data.constData(), data.size());
  * @brief Разбор сигнала телеметрии
  * @param[in] data 90 байт сырых данных от контроллера Пельтье 
  */
-void SerialPortWorker::ParseTelemetryRecord(const QList<uint8_t> &data) {
+void SerialPortWorker::ParseTelemetryRecord(std::span<const uint8_t> data) {
     if (data.size() != TelementrySize) {
         return;
     }
 
-auto p_data = static_cast<const uint8_t *>(data.constData());
-auto p_current = reinterpret_cast<const int16_t *>(p_data + 2);
-auto p_temperature = reinterpret_cast<const float *>(p_current + 40);
-auto p_reserved = reinterpret_cast<const uint32_t *>(p_temperature + 1);
-auto p_status = reinterpret_cast<const uint32_t *>(p_reserved + 1);
+TelemetryRecord record;
+    record.frame = TelemetryFrame::decode(data);
+    record.timestamp = m_clock.nsecsElapsed() / 1000;
+    PushTelemetry(record);
+}
+
+/**
+ * @brief Проверить порядковый номер кадра и передать кадр в GUI
+ *
+ * Повторы и опоздавшие кадры не передаются: их место на графике уже занято пропуском.
+ */
+void SerialPortWorker::PushTelemetry(TelemetryRecord &record) {
+    const auto result = m_frameTracker.update(record.frame.counter);
+    {
+        const QMutexLocker locker(&m_frameStatsLock);
+        m_frameStats = m_frameTracker.stats();
+    }
+
+    switch (result) {
+        case FrameCounterTracker::Result::Duplicate:
+            logger->warn("Telemetry frame {} duplicated", record.frame.counter);
+            return;
+
+        case FrameCounterTracker::Result::Reordered:
+            logger->warn("Telemetry frame {} reordered", record.frame.counter);
+            return;
+
+        case FrameCounterTracker::Result::Gap:
+            record.lost = m_frameTracker.lost();
+            logger->warn("Telemetry frames lost before {}: {}", record.frame.counter, record.lost);
+            break;
 
-    // 2 байта: порядковый номер фрейма
-uint16_t cnt;
-    ::memcpy(&cnt, p_data, sizeof(cnt));
+        case FrameCounterTracker::Result::Restart:
+            logger->warn("Telemetry counter restarted at {}", record.frame.counter);
+            break;
 
-    // 40 int16_t с током в мА
-QList<double> current;
-int16_t c;
-    for (int i = 0; i < 40; i++) {
-        current.append((*(p_current + i)) / 1000.0);
+        default:
+            break;
     }
 
-    emit telemetryRecv(current, *p_temperature, *p_status, *p_reserved);
+    m_telemetryQueue.push(record);
+}
+
+FrameCounterTracker::Stats SerialPortWorker::frameStats() const {
+const QMutexLocker locker(&m_frameStatsLock);
+    return m_frameStats;
 }
 
 
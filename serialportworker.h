@@ -1,15 +1,73 @@
 #ifndef SERIALPORTWORKER_H
 #define SERIALPORTWORKER_H
 
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <unordered_map>
+#include <type_traits>
 #include <QMutex>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
 #include <QThread>
 #include <QList>
+#include <QPointer>
 #include <QSerialPort>
 #include "spdlog/spdlog.h"
 #include "wake.h"
+#include "ringbuffer.h"
+#include "ttyport.h"
+#include "spscqueue.h"
+#include "framecounter.h"
+#include "commandqueue.h"
+#include "parametercache.h"
+#include "commanddescriptors.h"
 #include <proto.hpp>
 #include <commands.hpp>
 
+static constexpr int TelementrySize = 94;   ///< Размер кадра телеметрии, байт
+
+/**
+ * @brief Кадр телеметрии контроллера в том виде, как он приходит по линии
+ *
+ * Тривиально копируемый, передаётся по значению. Перевод тока в амперы - только там, где нужны double.
+ */
+#pragma pack(push, 1)
+struct TelemetryFrame {
+    uint16_t counter;                   ///< Порядковый номер кадра
+    std::array<int16_t, 40> current;    ///< Ток, мА
+    float temperature;                  ///< Температура, °C
+    uint32_t reserved;
+    uint32_t status;
+
+    /// Разбор из данных кадра Wake, размер должен быть равен TelementrySize
+    static TelemetryFrame decode(std::span<const uint8_t> data) {
+        TelemetryFrame frame;
+        ::memcpy(&frame, data.data(), sizeof(frame));
+        return frame;
+    }
+
+    double currentAmps(size_t index) const { return current[index] / 1000.0; }
+};
+#pragma pack(pop)
+static_assert(sizeof(TelemetryFrame) == TelementrySize, "TelemetryFrame must match the wire layout");
+static_assert(std::is_trivially_copyable_v<TelemetryFrame>);
+Q_DECLARE_METATYPE(TelemetryFrame)
+
+/**
+ * @brief Запись телеметрии в очереди от потока приёма к GUI, без динамической памяти
+ */
+struct TelemetryRecord {
+    TelemetryFrame frame;
+    qint64 timestamp;                   ///< Время приёма, мкс от запуска потока
+    uint16_t lost = 0;                  ///< Кадров потеряно перед этим (по порядковому номеру)
+};
+
+static constexpr size_t TelemetryQueueSize = 1024;     ///< ~20 секунд телеметрии при 50 кадрах/с
+using TelemetryQueue = SpscQueue<TelemetryRecord, TelemetryQueueSize>;
+
 class SerialPortWorker : public QThread {
     Q_OBJECT
 
@@ -21,17 +79,64 @@ public:
     static QList<QPair<QString, QString>> availablePorts();
 
     enum CommandError {
-        Busy = 0,           ///< Начало выполнения команды
+        Busy = 0,           ///< Команда поставлена в очередь
         NoError = 1,        ///< Команда выполнена
-        Error = 3,          ///< Команда вернула ошибку
-        TimeoutError = 4    ///< Команда прервана по таймауту
+        Error = 3,          ///< Команда вернула ошибку или отклонена (очередь переполнена, порт закрыт)
+        TimeoutError = 4    ///< Нет ответа после всех повторов
     };
     Q_ENUM(CommandError);
 
+    using RequestId = uint32_t;
+    using CommandCallback = std::function<void(CommandError error, const QByteArray &data)>;
+
+    RequestId request(tec::Commands cmd, const QByteArray &payload, CommandCallback callback = {}, QObject *context = nullptr,
+                      qint64 timeoutMs = -1, int retries = -1);
+
+    /// Очередь команд: в полёте, ожидают передачи, повторных передач и отказов по таймауту за сессию
+    struct CommandStats {
+        size_t inFlight;
+        size_t pending;
+        uint64_t retransmits;
+        uint64_t timeouts;
+        uint64_t pollTimeouts;  ///< Узел шины не ответил на опрос телеметрии
+    };
+    CommandStats commandStats() const;
+
+    static constexpr qint64 DefaultCacheMaxAge = 5000;     ///< Срок годности кэша параметров, мс
+    void setParameterCache(std::shared_ptr<ParameterCache> cache, qint64 maxAgeMs = DefaultCacheMaxAge);
+
+    /// Очередь приёма: сколько данных ждало разбора на последнем проходе и максимум за сессию
+    struct Backlog {
+        qint64 bytes;
+        qint64 frames;
+        qint64 maxBytes;
+        qint64 maxFrames;
+    };
+    Backlog backlog() const;
+
+    /// Транспорт последовательного порта
+    enum class Transport {
+        QtSerialPort,   ///< QSerialPort с опросом waitForReadyRead
+        NativeTty       ///< termios + epoll, только Linux
+    };
+    void setTransport(Transport transport) { m_transport = transport; }
+
+    /// Контроль порядковых номеров телеметрии за сессию
+    FrameCounterTracker::Stats frameStats() const;
+
+    /// Очередь телеметрии. Читать только из одного потока (GUI)
+    TelemetryQueue &telemetryQueue() { return m_telemetryQueue; }
+
+    static constexpr qint64 PollInterval = 20;     ///< Период опроса телеметрии узла шины, мс
+    static constexpr qint64 PollTimeout = 10;      ///< Ожидание ответа на опрос, мс
+
+    void attachToBus(SerialPortWorker *link, uint8_t address);
+    int address() const;
+
 signals:
     void error(const QString &s);
-    void telemetryRecv(QList<double> current, double temperature, uint32_t status, uint32_t reserved);
     void commandExecute(CommandError error, tec::Commands command, const QByteArray &data);
+    void requestFinished(RequestId id, CommandError error, tec::Commands command, const QByteArray &data);
 
 public slots:
     void recvValid(const QList<uint8_t> &data, uint8_t command);
@@ -42,6 +147,8 @@ public slots:
     void setOutputVoltage(double voltagePercent);
     void getOutputVoltage();
     void setCommandTimeout(qint64 timeoutMs) { m_commandTimeout = timeoutMs; }
+    void setCommandRetries(int retries) { m_commandRetries = retries; }
+    void setCommandWindow(int window);
     
     void setCurrentPid(PidVariableType type, double value);
     void getCurrentPid(PidVariableType type);
@@ -66,34 +173,99 @@ public slots:
     void saveSettingsToEeprom();
 
 private:
-static const int TelementrySize = 94;
+static constexpr qint64 ReadBufferSize = 1024 * 1024;   ///< Размер буфера приёма QSerialPort и кольцевого буфера декодера
+static constexpr size_t DecodeSliceSize = 4096;         ///< Порция разбора между обслуживаниями передачи
 
     void run() override;
 
-    void commandTransmit(tec::Commands cmd, const QByteArray &tx);
-    void commandTransmit(tec::Commands cmd);
-
     bool m_isSimulator;
     QString m_portName;
     int m_waitTimeout = 0;
     qint64 m_commandTimeout = 1000;
+    int m_commandRetries = 1;
 
-    QMutex m_mutex;
+    mutable QMutex m_mutex;
     bool m_quit = false;
 
     std::shared_ptr<spdlog::logger> logger;
 
     void runSimulator();
     void runSerial();
+    static void ReadToRing(QSerialPort &serial, ByteRingBuffer &ring);
+    void HandleFrame(const Wake::Frame &frame);
+    template <typename Port> void DecodeRing(Wake &wake, ByteRingBuffer &ring, Port &port);
+    template <typename Port> void ServiceCommand(Port &port);
+    template <typename Port> void ServiceBus(Port &port);
+    template <typename Port> bool ServiceNode(Port &port, bool transmit);
+    qint64 NextTimeout();
+    void RouteFrame(const Wake::Frame &frame);
+    void AddNode(SerialPortWorker *node);
+    void RemoveNode(SerialPortWorker *node);
+    void DetachFromBus();
+    void FinishRequest(const CommandRequest &request, CommandError error, const QByteArray &data = QByteArray());
+    void UpdateCache(const CommandRequest &request, const QByteArray &reply);
+    void AbortRequests();
+
+    RequestId Submit(tec::Commands cmd, std::span<const uint8_t> payload, std::span<const uint8_t> frame, CommandCallback callback = {},
+                     QObject *context = nullptr, qint64 timeoutMs = -1, int retries = -1);
+    template <typename Descriptor, size_t Payload>
+    RequestId Submit(const Wake::TxFrame<Payload> &frame) {
+        return Submit(Descriptor::command, frame.payload, frame.bytes());
+    }
+    void WakeTransport();
+
+    Transport m_transport = Transport::QtSerialPort;
+#ifdef __linux__
+    void runTty();
+    static void ReadToRing(TtyPort &tty, ByteRingBuffer &ring);
+    TtyPort *m_tty = nullptr;
+#endif
+    void UpdateBacklog(qint64 bytes, qint64 frames);
+
+    std::atomic<qint64> m_backlogBytes = 0;
+    std::atomic<qint64> m_backlogFrames = 0;
+    std::atomic<qint64> m_backlogBytesMax = 0;
+    std::atomic<qint64> m_backlogFramesMax = 0;
 
     static constexpr uint32_t SinTableSize = 1024;
     static constexpr uint32_t SinTableModMask = SinTableSize - 1;
     QVector<double> m_phaseTable;
     
-    QByteArray m_txDataPending;
-    uint8_t m_commandPending = qToUnderlying(tec::Commands::Invalid);
+    /// Обработчик ответа, вызывается в потоке context
+    struct RequestCallback {
+        CommandCallback callback;
+        QPointer<QObject> context;
+        bool hasContext;
+    };
+
+    CommandQueue m_commands;                                        ///< Под m_mutex
+    std::unordered_map<RequestId, RequestCallback> m_callbacks;     ///< Под m_mutex
+    RequestId m_nextRequestId = 1;
+    uint64_t m_commandTimeouts = 0;
+    uint64_t m_pollTimeouts = 0;
+    std::shared_ptr<ParameterCache> m_cache;                        ///< Под m_mutex
+    qint64 m_cacheMaxAge = DefaultCacheMaxAge;
     
-    void ParseTelemetryRecord(const QList<uint8_t> &data);
+    void ParseTelemetryRecord(std::span<const uint8_t> data);
+    void PushTelemetry(TelemetryRecord &record);
+
+    FrameCounterTracker m_frameTracker;         ///< Только поток приёма
+    FrameCounterTracker::Stats m_frameStats;    ///< Копия для GUI под m_frameStatsLock
+    mutable QMutex m_frameStatsLock;
+
+    TelemetryQueue m_telemetryQueue;
+    QElapsedTimer m_clock;
+
+    // Шина RS-485. Поток линии (link) открывает порт и обслуживает узлы, узел своего потока не запускает:
+    // его очередь команд и телеметрии обслуживает поток линии, кадры уходят с адресом узла
+    SerialPortWorker *m_bus = nullptr;          ///< Линия узла, под m_mutex. Живёт дольше узла
+    int m_address = Wake::NoAddress;            ///< Адрес узла, задаётся до подключения к линии
+    QByteArray m_pollFrame;                     ///< Запрос телеметрии узла, пустой - без опроса
+    qint64 m_lastPoll = -1;                     ///< Время последнего опроса по m_clock, только поток линии
+
+    mutable QMutex m_nodesLock;                 ///< Захватывается раньше m_mutex узлов
+    QList<SerialPortWorker *> m_nodes;          ///< Узлы линии, под m_nodesLock
+    qsizetype m_nextNode = 0;                   ///< Следующий узел в очереди на передачу, под m_nodesLock
 };
 
 #endif // SERIALPORTWORKER_H
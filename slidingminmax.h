@@ -0,0 +1,128 @@
+#ifndef SLIDINGMINMAX_H
+#define SLIDINGMINMAX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Минимум и максимум последних отсчётов на монотонных очередях
+ *
+ * Добавление отсчёта - O(1) амортизированно. Очередь минимумов хранит минимумы всех суффиксов окна с возрастающими
+ * номерами, поэтому минимум любого отрезка [begin, total()) внутри окна находится двоичным поиском.
+ * Номера отсчётов абсолютные, как в SampleRing.
+ */
+class SlidingMinMax {
+public:
+    void reset(size_t window) {
+        m_window = std::max<size_t>(window, 1);
+        m_min.reset(m_window + 1);
+        m_max.reset(m_window + 1);
+        m_total = 0;
+    }
+
+    void clear() {
+        m_min.clear();
+        m_max.clear();
+        m_total = 0;
+    }
+
+    void append(const double *data, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            const uint64_t index = m_total++;
+            m_min.push(index, data[i], [](double back, double v) { return back >= v; });
+            m_max.push(index, data[i], [](double back, double v) { return back <= v; });
+        }
+
+        const uint64_t first = m_total > m_window ? m_total - m_window : 0;
+        m_min.dropBefore(first);
+        m_max.dropBefore(first);
+    }
+
+    uint64_t total() const { return m_total; }
+    /// Номер самого старого отсчёта окна
+    uint64_t first() const { return m_total > m_window ? m_total - m_window : 0; }
+    bool isEmpty() const { return m_total == 0; }
+
+    /// Минимум отсчётов [begin, total()), first() <= begin < total()
+    double min(uint64_t begin) const { return m_min.fromIndex(begin); }
+    /// Максимум отсчётов [begin, total()), first() <= begin < total()
+    double max(uint64_t begin) const { return m_max.fromIndex(begin); }
+
+private:
+    /// Дек на кольце фиксированной ёмкости (степень двойки): индексы возрастают от головы к хвосту
+    class Deque {
+    public:
+        void reset(size_t capacity) {
+            size_t c = 1;
+            while (c < capacity) {
+                c <<= 1;
+            }
+            m_items.resize(c);
+            m_mask = c - 1;
+            clear();
+        }
+
+        void clear() { m_head = m_size = 0; }
+
+        template <typename Dominated>
+        void push(uint64_t index, double value, Dominated dominated) {
+            while (m_size > 0 && dominated(at(m_size - 1).value, value)) {
+                m_size--;
+            }
+            // Внутри блока dropBefore() не вызывается, при заполнении голова заведомо вне окна
+            if (m_size == m_items.size()) {
+                pop();
+            }
+            Item &item = at(m_size++);
+            item.index = index;
+            item.value = value;
+        }
+
+        void dropBefore(uint64_t index) {
+            while (m_size > 0 && at(0).index < index) {
+                pop();
+            }
+        }
+
+        double fromIndex(uint64_t index) const {
+            size_t lo = 0;
+            size_t hi = m_size;
+            while (lo < hi) {
+                const size_t mid = (lo + hi) / 2;
+                if (at(mid).index < index) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            return lo < m_size ? at(lo).value : 0.0;
+        }
+
+    private:
+        struct Item {
+            uint64_t index;
+            double value;
+        };
+
+        std::vector<Item> m_items;
+        size_t m_mask = 0;
+        size_t m_head = 0;
+        size_t m_size = 0;
+
+        Item &at(size_t i) { return m_items[(m_head + i) & m_mask]; }
+        const Item &at(size_t i) const { return m_items[(m_head + i) & m_mask]; }
+        void pop() {
+            m_head = (m_head + 1) & m_mask;
+            m_size--;
+        }
+    };
+
+    Deque m_min;
+    Deque m_max;
+    size_t m_window = 1;
+    uint64_t m_total = 0;
+};
+
+#endif // SLIDINGMINMAX_H
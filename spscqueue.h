@@ -0,0 +1,81 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Очередь без блокировок на одного писателя и одного читателя с заранее выделенной памятью
+ *
+ * Писатель - поток приёма, читатель - поток GUI. При переполнении новая запись отбрасывается и учитывается
+ * в drops(). highWaterMark() - наибольшая заполненность очереди за время жизни.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    bool push(const T &value) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t tail = m_tail.load(std::memory_order_acquire);
+        if (head - tail == Capacity) {
+            m_drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_buffer[head & Mask] = value;
+        m_head.store(head + 1, std::memory_order_release);
+
+        const size_t used = head + 1 - tail;
+        if (used > m_highWater.load(std::memory_order_relaxed)) {
+            m_highWater.store(used, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    bool pop(T &value) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t head = m_head.load(std::memory_order_acquire);
+        if (tail == head) {
+            return false;
+        }
+
+        value = m_buffer[tail & Mask];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Забрать все записи, доступные на момент вызова
+     * @param[in] func - обработчик, вызывается для каждой записи по константной ссылке
+     * @return Количество обработанных записей
+     */
+    template <typename Func>
+    size_t drain(Func &&func) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t head = m_head.load(std::memory_order_acquire);
+        const size_t count = head - tail;
+        for (; tail != head; ++tail) {
+            func(static_cast<const T &>(m_buffer[tail & Mask]));
+            m_tail.store(tail + 1, std::memory_order_release);
+        }
+        return count;
+    }
+
+    size_t size() const { return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire); }
+    static constexpr size_t capacity() { return Capacity; }
+    size_t highWaterMark() const { return m_highWater.load(std::memory_order_relaxed); }
+    size_t drops() const { return m_drops.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t Mask = Capacity - 1;
+
+    alignas(64) std::atomic<size_t> m_head = 0;     ///< Пишет только писатель
+    alignas(64) std::atomic<size_t> m_tail = 0;     ///< Пишет только читатель
+    alignas(64) std::atomic<size_t> m_highWater = 0;
+    std::atomic<size_t> m_drops = 0;
+    std::array<T, Capacity> m_buffer{};
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,40 @@
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include "gltracewidget.h"
+#include "rastertracewidget.h"
+#include "streamingtrace.h"
+
+
+/**
+ * @brief Проверить, что можно создать контекст OpenGL нужной версии
+ */
+bool StreamingTrace::openGlAvailable() {
+QOpenGLContext context;
+QOffscreenSurface surface;
+
+    context.setFormat(GlTraceWidget::surfaceFormat());
+    if (!context.create()) {
+        return false;
+    }
+
+    surface.setFormat(context.format());
+    surface.create();
+    if (!surface.isValid() || !context.makeCurrent(&surface)) {
+        return false;
+    }
+
+    const auto version = context.format().version();
+    context.doneCurrent();
+    return version >= GlTraceWidget::surfaceFormat().version();
+}
+
+/**
+ * @brief Создать график потока
+ * @param[in] openGl - использовать OpenGL, если доступен, иначе программную отрисовку
+ */
+StreamingTrace *StreamingTrace::create(bool openGl, QWidget *parent) {
+    if (openGl && openGlAvailable()) {
+        return new GlTraceWidget(parent);
+    }
+    return new RasterTraceWidget(parent);
+}
@@ -0,0 +1,37 @@
+#ifndef STREAMINGTRACE_H
+#define STREAMINGTRACE_H
+
+#include <cstddef>
+#include <QtGlobal>
+
+QT_FORWARD_DECLARE_CLASS(QWidget);
+
+/**
+ * @brief График потока отсчётов с фиксированным окном, последний отсчёт у правого края
+ *
+ * Реализации: GlTraceWidget - кольцевой буфер вершин на GPU, за кадр передаётся только новый блок;
+ * RasterTraceWidget - программная отрисовка QPainter по прореженным отсчётам, если OpenGL недоступен.
+ * Перерисовка - по такту RefreshScheduler через render().
+ */
+class StreamingTrace {
+public:
+    virtual ~StreamingTrace() = default;
+
+    virtual QWidget *widget() = 0;
+
+    virtual void append(const double *data, size_t count) = 0;
+    /// Пропуск потерянных отсчётов: окно сдвигается, линия через пропуск не рисуется
+    virtual void addGap(size_t samples) = 0;
+    virtual void clear() = 0;
+    /// Ширина окна, отсчётов
+    virtual void setWindow(size_t samples) = 0;
+    /// Диапазон по Y, при lo >= hi - по данным окна
+    virtual void setRange(double lo, double hi) = 0;
+    /// Запросить перерисовку, если есть новые данные. true - перерисовка запрошена
+    virtual bool render() = 0;
+
+    static bool openGlAvailable();
+    static StreamingTrace *create(bool openGl, QWidget *parent = nullptr);
+};
+
+#endif // STREAMINGTRACE_H
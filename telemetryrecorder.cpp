@@ -0,0 +1,107 @@
+#include <QDateTime>
+#include <QElapsedTimer>
+#include "telemetryrecorder.h"
+
+
+TelemetryRecorder::TelemetryRecorder(const QString &fileName, QObject *parent) : m_fileName(fileName), m_file(fileName), QThread(parent) {
+    logger = spdlog::get("IO");
+}
+
+TelemetryRecorder::~TelemetryRecorder() {
+    close();
+}
+
+/**
+ * @brief Создать файл, записать заголовок и запустить поток записи
+ * @param[in] info - параметры записи для заголовка
+ */
+bool TelemetryRecorder::open(const Info &info) {
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        logger->error("Cannot open record {}: {}", m_fileName.toStdString(), m_file.errorString().toStdString());
+        return false;
+    }
+
+record::RecordFileHeader header{};
+    ::memcpy(header.magic, record::Magic, sizeof(header.magic));
+    header.version = record::Version;
+    header.headerSize = sizeof(header);
+    header.samplesPerFrame = std::tuple_size_v<decltype(TelemetryFrame::current)>;
+    header.timebase = info.timebase;
+    header.currentScale = 1e-3;
+    header.startTime = QDateTime::currentMSecsSinceEpoch();
+    header.hardwareVersion = info.hardwareVersion;
+    header.firmwareVersion = info.firmwareVersion;
+    ::strncpy(header.appVersion, _APP_VERSION, sizeof(header.appVersion) - 1);
+
+    m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    logger->info("Record {} started", m_fileName.toStdString());
+    m_quit = false;
+    start();
+    return true;
+}
+
+/**
+ * @brief Дописать всё из очереди и закрыть файл
+ */
+void TelemetryRecorder::close() {
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    m_quit = true;
+    wait();
+    m_file.close();
+    logger->info("Record {} stopped: {} frames, {} dropped", m_fileName.toStdString(), m_frames.load(), drops());
+}
+
+/**
+ * @brief Поставить кадр в очередь записи. Вызывается из одного потока
+ * @return false, если очередь переполнена и кадр отброшен
+ */
+bool TelemetryRecorder::append(const TelemetryRecord &record) {
+    return m_queue.push(record);
+}
+
+void TelemetryRecorder::run() {
+QByteArray buffer;
+QElapsedTimer flushTimer;
+    buffer.reserve(WriteChunkSize + QueueSize * (sizeof(record::RecordTelemetryBlock) + sizeof(record::RecordGapBlock)));
+    flushTimer.start();
+
+    while (!m_quit) {
+        QThread::msleep(50);
+        Drain(buffer);
+        if (buffer.size() >= WriteChunkSize || (!buffer.isEmpty() && flushTimer.hasExpired(FlushInterval))) {
+            if (m_file.write(buffer) != buffer.size()) {
+                emit error(QString("Record write error: %1").arg(m_file.errorString()));
+            }
+            buffer.resize(0);
+            flushTimer.restart();
+        }
+    }
+
+    Drain(buffer);
+    m_file.write(buffer);
+}
+
+void TelemetryRecorder::Drain(QByteArray &buffer) {
+    auto count = m_queue.drain([&buffer](const TelemetryRecord &rec) {
+        if (rec.lost > 0) {
+            record::RecordGapBlock gap;
+            gap.header.type = qToUnderlying(record::BlockType::Gap);
+            gap.header.size = sizeof(gap) - sizeof(gap.header);
+            gap.timestamp = rec.timestamp;
+            gap.counter = rec.frame.counter;
+            gap.lost = rec.lost;
+            buffer.append(reinterpret_cast<const char *>(&gap), sizeof(gap));
+        }
+
+        record::RecordTelemetryBlock block;
+        block.header.type = qToUnderlying(record::BlockType::Telemetry);
+        block.header.size = sizeof(block) - sizeof(block.header);
+        block.timestamp = rec.timestamp;
+        block.frame = rec.frame;
+        buffer.append(reinterpret_cast<const char *>(&block), sizeof(block));
+    });
+    m_frames += count;
+}
@@ -0,0 +1,113 @@
+#ifndef TELEMETRYRECORDER_H
+#define TELEMETRYRECORDER_H
+
+#include <atomic>
+#include <QFile>
+#include <QThread>
+#include "serialportworker.h"
+
+/**
+ * @brief Двоичный формат записи телеметрии (little endian)
+ *
+ * Файл: RecordFileHeader, затем блоки RecordBlockHeader + данные. Блок телеметрии - RecordTelemetryBlock,
+ * потерянные кадры отмечены RecordGapBlock перед следующим принятым кадром.
+ * Блоки неизвестного типа пропускаются по размеру. Преобразование в CSV - Utils/convert.py.
+ */
+namespace record {
+
+static constexpr char Magic[8] = {'Q', 'P', 'T', 'R', 'E', 'C', 0, 0};
+static constexpr uint16_t Version = 1;
+
+enum class BlockType : uint16_t {
+    Telemetry = 1,
+    Gap = 2             ///< Перед следующим блоком телеметрии потеряны кадры
+};
+
+#pragma pack(push, 1)
+struct RecordFileHeader {
+    char magic[8];
+    uint16_t version;
+    uint16_t headerSize;        ///< sizeof(RecordFileHeader), для совместимости со следующими версиями
+    uint16_t samplesPerFrame;   ///< Отсчётов тока в кадре
+    uint16_t reserved;
+    double timebase;            ///< Период отсчёта тока, секунд
+    double currentScale;        ///< Ампер на единицу отсчёта тока
+    int64_t startTime;          ///< Начало записи, мс от эпохи UTC
+    uint32_t hardwareVersion;   ///< Версия контроллера, 0 - неизвестна
+    uint32_t firmwareVersion;
+    char appVersion[16];
+};
+
+struct RecordBlockHeader {
+    uint16_t type;              ///< BlockType
+    uint16_t size;              ///< Размер данных блока без заголовка, байт
+};
+
+struct RecordTelemetryBlock {
+    RecordBlockHeader header;
+    int64_t timestamp;          ///< Время приёма, мкс
+    TelemetryFrame frame;
+};
+
+struct RecordGapBlock {
+    RecordBlockHeader header;
+    int64_t timestamp;          ///< Время приёма кадра после пропуска, мкс
+    uint16_t counter;           ///< Порядковый номер кадра после пропуска
+    uint16_t lost;              ///< Потеряно кадров
+};
+#pragma pack(pop)
+
+static_assert(sizeof(RecordFileHeader) == 64);
+static_assert(sizeof(RecordTelemetryBlock) == 4 + 8 + TelementrySize);
+static_assert(sizeof(RecordGapBlock) == 4 + 8 + 2 + 2);
+
+} // namespace record
+
+/**
+ * @brief Запись телеметрии в двоичный файл в отдельном потоке
+ *
+ * append() только кладёт запись в очередь без блокировок и без выделения памяти, поток записи
+ * собирает блоки в буфер и пишет их крупными порциями.
+ */
+class TelemetryRecorder : public QThread {
+    Q_OBJECT
+
+public:
+    TelemetryRecorder(const QString &fileName, QObject *parent = nullptr);
+    ~TelemetryRecorder();
+
+    struct Info {
+        double timebase = 500e-6;
+        uint32_t hardwareVersion = 0;
+        uint32_t firmwareVersion = 0;
+    };
+
+    bool open(const Info &info);
+    void close();
+
+    bool append(const TelemetryRecord &record);
+
+    QString fileName() const { return m_fileName; }
+    qint64 frames() const { return m_frames; }
+    size_t drops() const { return m_queue.drops(); }
+
+signals:
+    void error(const QString &s);
+
+private:
+    static constexpr size_t QueueSize = 4096;               ///< ~80 секунд телеметрии при 50 кадрах/с
+    static constexpr qsizetype WriteChunkSize = 64 * 1024;  ///< Порог записи буфера в файл, байт
+    static constexpr int FlushInterval = 500;               ///< Максимальное время данных в буфере, мс
+
+    void run() override;
+    void Drain(QByteArray &buffer);
+
+    std::shared_ptr<spdlog::logger> logger;
+    QString m_fileName;
+    QFile m_file;
+    SpscQueue<TelemetryRecord, QueueSize> m_queue;
+    std::atomic<bool> m_quit = false;
+    std::atomic<qint64> m_frames = 0;
+};
+
+#endif // TELEMETRYRECORDER_H
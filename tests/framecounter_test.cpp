@@ -0,0 +1,56 @@
+#include <gtest/gtest.h>
+#include "framecounter.h"
+
+using Result = FrameCounterTracker::Result;
+
+TEST(FrameCounterTracker, GapAcrossWrap) {
+FrameCounterTracker tracker;
+    EXPECT_EQ(tracker.update(0xFFFE), Result::First);
+    EXPECT_EQ(tracker.update(0xFFFF), Result::InOrder);
+    EXPECT_EQ(tracker.update(0x0003), Result::Gap);
+    EXPECT_EQ(tracker.lost(), 3);
+    EXPECT_EQ(tracker.update(0x0001), Result::Reordered);
+    EXPECT_EQ(tracker.update(0x0001), Result::Duplicate);
+    EXPECT_EQ(tracker.stats().lost, 2u);
+}
+
+TEST(FrameCounterTracker, LargestGapIsCounted) {
+FrameCounterTracker tracker;
+    tracker.update(100);
+    EXPECT_EQ(tracker.update(101 + FrameCounterTracker::MaxGap), Result::Gap);
+    EXPECT_EQ(tracker.lost(), FrameCounterTracker::MaxGap);
+}
+
+/// Испорченный номер или перезапуск посередине диапазона не должен давать десятки тысяч потерянных кадров
+TEST(FrameCounterTracker, FarJumpIsRestart) {
+FrameCounterTracker tracker;
+    tracker.update(100);
+    EXPECT_EQ(tracker.update(102 + FrameCounterTracker::MaxGap), Result::Restart);
+    EXPECT_EQ(tracker.lost(), 0);
+    EXPECT_EQ(tracker.update(100 + 0x7FFF), Result::Restart);
+    EXPECT_EQ(tracker.update(100 + 0x8000), Result::InOrder);
+
+const auto &stats = tracker.stats();
+    EXPECT_EQ(stats.lost, 0u);
+    EXPECT_EQ(stats.restarts, 2u);
+    EXPECT_EQ(stats.received, 4u);
+}
+
+/// Кадр старше первого не был учтён потерянным - счётчик потерь не уходит ниже нуля
+TEST(FrameCounterTracker, LateFrameAfterFirst) {
+FrameCounterTracker tracker;
+    EXPECT_EQ(tracker.update(100), Result::First);
+    EXPECT_EQ(tracker.update(99), Result::Duplicate);
+    EXPECT_EQ(tracker.stats().lost, 0u);
+    EXPECT_EQ(tracker.stats().reordered, 0u);
+}
+
+TEST(FrameCounterTracker, LateFrameAfterRestart) {
+FrameCounterTracker tracker;
+    tracker.update(5);
+    tracker.update(6);
+    EXPECT_EQ(tracker.update(9000), Result::Restart);
+    EXPECT_EQ(tracker.update(8990), Result::Duplicate);
+    EXPECT_EQ(tracker.stats().lost, 0u);
+    EXPECT_EQ(tracker.stats().received, 3u);
+}
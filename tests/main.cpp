@@ -0,0 +1,13 @@
+#include <gtest/gtest.h>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/null_sink.h>
+
+int main(int argc, char **argv) {
+    // Классы проекта берут логгеры по имени, в тестах вывод не нужен
+    for (const auto name : {"IO", "Serial", "Wake"}) {
+        spdlog::create<spdlog::sinks::null_sink_mt>(name);
+    }
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
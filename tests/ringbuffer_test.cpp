@@ -0,0 +1,137 @@
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <vector>
+#include <gtest/gtest.h>
+#include "ringbuffer.h"
+#include "wake.h"
+
+namespace {
+
+constexpr size_t ReadBufferSize = 1024 * 1024;      ///< Как SerialPortWorker::ReadBufferSize
+constexpr size_t DecodeSliceSize = 4096;            ///< Как SerialPortWorker::DecodeSliceSize
+
+/// Поток кадров телеметрии (94 байта данных) не короче size байт
+std::vector<uint8_t> TelemetryStream(size_t size) {
+QByteArray data(94, Qt::Uninitialized);
+    for (int i = 0; i < data.size(); i++) {
+        data[i] = static_cast<char>(i * 37);      // С FEND/FESC в данных
+    }
+const auto tx = Wake::PrepareTx(0x05, data);
+std::vector<uint8_t> stream;
+    while (stream.size() < size) {
+        stream.insert(stream.end(), tx.begin(), tx.end());
+    }
+    return stream;
+}
+
+/// Записать весь источник в кольцо, как ReadToRing после простоя
+void Fill(ByteRingBuffer &ring, const std::vector<uint8_t> &src) {
+size_t pos = 0;
+    while (pos < src.size()) {
+        auto span = ring.writeSpan();
+        ASSERT_FALSE(span.empty());
+        const size_t n = std::min(span.size(), src.size() - pos);
+        ::memcpy(span.data(), src.data() + pos, n);
+        ring.commit(n);
+        pos += n;
+    }
+}
+
+/// Лучшее из нескольких время разбора пачки size байт, секунд
+double DecodeBurst(size_t size, size_t &frames) {
+auto stream = TelemetryStream(size);
+    stream.resize(size);
+double best = 1e9;
+    for (int run = 0; run < 5; run++) {
+        ByteRingBuffer ring(ReadBufferSize);
+        Wake wake;
+        Fill(ring, stream);
+        frames = 0;
+        const auto start = std::chrono::steady_clock::now();
+        wake.processRing(ring, DecodeSliceSize, [&frames](const Wake::Frame &) { frames++; }, []() {});
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+}
+
+TEST(ByteRingBuffer, CapacityRoundsUpToPowerOfTwo) {
+    EXPECT_EQ(ByteRingBuffer(1000).capacity(), 1024u);
+    EXPECT_EQ(ByteRingBuffer(ReadBufferSize).capacity(), ReadBufferSize);
+}
+
+TEST(ByteRingBuffer, SpansWrapAround) {
+ByteRingBuffer ring(16);
+std::vector<uint8_t> out;
+uint8_t next = 0;
+    // Смещаем курсоры так, чтобы запись и чтение пересекали конец буфера
+    for (int round = 0; round < 10; round++) {
+        while (ring.free() > 0) {
+            auto span = ring.writeSpan();
+            const size_t n = std::min<size_t>(span.size(), 5);
+            for (size_t i = 0; i < n; i++) {
+                span[i] = next++;
+            }
+            ring.commit(n);
+        }
+        EXPECT_EQ(ring.size(), ring.capacity());
+
+        for (size_t taken = 0; taken < 11 && !ring.isEmpty();) {
+            auto span = ring.readSpan();
+            const size_t n = std::min(span.size(), 11 - taken);
+            out.insert(out.end(), span.begin(), span.begin() + n);
+            ring.consume(n);
+            taken += n;
+        }
+    }
+    while (!ring.isEmpty()) {
+        auto span = ring.readSpan();
+        out.insert(out.end(), span.begin(), span.end());
+        ring.consume(span.size());
+    }
+
+std::vector<uint8_t> expected(out.size());
+    std::iota(expected.begin(), expected.end(), uint8_t(0));
+    EXPECT_EQ(out, expected);
+}
+
+TEST(ByteRingBuffer, ProcessRingDecodesWholeBurst) {
+auto stream = TelemetryStream(ReadBufferSize);
+    stream.resize(ReadBufferSize);
+ByteRingBuffer ring(ReadBufferSize);
+    Fill(ring, stream);
+    ASSERT_EQ(ring.free(), 0u);
+
+Wake reference;
+size_t expected = 0;
+    for (auto b : stream) {
+        expected += reference.ProcessInByte(b) == Wake::READY;
+    }
+
+Wake wake;
+size_t frames = 0;
+size_t slices = 0;
+    const auto count = wake.processRing(ring, DecodeSliceSize, [&frames](const Wake::Frame &frame) {
+        EXPECT_EQ(frame.data.size(), 94u);
+        frames++;
+    }, [&slices]() { slices++; });
+
+    EXPECT_TRUE(ring.isEmpty());
+    EXPECT_EQ(count, frames);
+    EXPECT_EQ(frames, expected);
+    EXPECT_EQ(slices, ReadBufferSize / DecodeSliceSize);
+}
+
+/**
+ * @brief Время разбора пачки растёт линейно: 1 МБ не дольше 8 раз по 256 КБ (квадратичный рост дал бы 16)
+ */
+TEST(ByteRingBuffer, BurstDecodeIsLinear) {
+size_t smallFrames = 0;
+size_t largeFrames = 0;
+const double small = DecodeBurst(ReadBufferSize / 4, smallFrames);
+const double large = DecodeBurst(ReadBufferSize, largeFrames);
+    EXPECT_NEAR(static_cast<double>(largeFrames) / smallFrames, 4.0, 0.01);
+    EXPECT_LT(large / small, 8.0) << "256 KB: " << small * 1e3 << " ms, 1 MB: " << large * 1e3 << " ms";
+}
@@ -0,0 +1,103 @@
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <pty.h>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include "ttyport.h"
+
+namespace {
+
+/**
+ * @brief Пара псевдотерминала: TtyPort открывает ведомую сторону, тест пишет и читает ведущую
+ */
+class TtyPortTest : public ::testing::Test {
+protected:
+    int m_master = -1;
+    int m_slave = -1;
+    char m_name[128] = {};
+    TtyPort m_port;
+
+    void SetUp() override {
+        ASSERT_EQ(::openpty(&m_master, &m_slave, m_name, nullptr, nullptr), 0);
+        ASSERT_TRUE(m_port.open(m_name, 921600)) << m_port.errorString().toStdString();
+    }
+
+    void TearDown() override {
+        m_port.close();
+        if (m_slave >= 0) {
+            ::close(m_slave);
+        }
+        if (m_master >= 0) {
+            ::close(m_master);
+        }
+    }
+};
+
+}
+
+TEST_F(TtyPortTest, WakeInterruptsWait) {
+std::thread waker([this]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        m_port.wake();
+    });
+const auto start = std::chrono::steady_clock::now();
+const int events = m_port.wait(5000);
+const auto elapsed = std::chrono::steady_clock::now() - start;
+    waker.join();
+
+    EXPECT_EQ(events, TtyPort::Woken);
+    EXPECT_LT(elapsed, std::chrono::milliseconds(2000));
+    EXPECT_EQ(m_port.wait(0), 0) << "wake() must be consumed by one wait()";
+}
+
+TEST_F(TtyPortTest, WaitTimesOut) {
+    EXPECT_EQ(m_port.wait(20), 0);
+}
+
+TEST_F(TtyPortTest, ReadsWhatMasterWrites) {
+const uint8_t frame[] = {0xC0, 0x05, 0x03, 0xDB, 0xDC, 0x11, 0x22, 0x7A};
+    ASSERT_EQ(::write(m_master, frame, sizeof(frame)), static_cast<ssize_t>(sizeof(frame)));
+
+uint8_t buffer[64];
+size_t received = 0;
+    // Псевдотерминал может отдать данные несколькими частями
+    while (received < sizeof(frame)) {
+        ASSERT_TRUE(m_port.wait(1000) & TtyPort::Readable);
+        const auto n = m_port.read(buffer + received, sizeof(buffer) - received);
+        ASSERT_GE(n, 0);
+        received += n;
+    }
+    ASSERT_EQ(received, sizeof(frame));
+    EXPECT_EQ(::memcmp(buffer, frame, sizeof(frame)), 0);
+    EXPECT_EQ(m_port.bytesAvailable(), 0);
+}
+
+TEST_F(TtyPortTest, WriteReachesMaster) {
+const QByteArray data("\xC0\x01\x00\x4B", 4);
+    ASSERT_EQ(m_port.write(data), data.size());
+
+char buffer[16];
+ssize_t received = 0;
+    while (received < data.size()) {
+        const auto n = ::read(m_master, buffer + received, sizeof(buffer) - received);
+        ASSERT_GT(n, 0);
+        received += n;
+    }
+    EXPECT_EQ(QByteArray(buffer, static_cast<int>(received)), data);
+}
+
+TEST_F(TtyPortTest, HangupReportsError) {
+    ::close(m_master);
+    m_master = -1;
+
+    EXPECT_TRUE(m_port.wait(1000) & TtyPort::Error);
+    EXPECT_FALSE(m_port.errorString().isEmpty());
+}
+
+TEST(TtyPort, OpenFailsForMissingDevice) {
+TtyPort port;
+    EXPECT_FALSE(port.open("/dev/qpeltierui-no-such-tty", 921600));
+    EXPECT_FALSE(port.isOpen());
+    EXPECT_FALSE(port.errorString().isEmpty());
+}
@@ -0,0 +1,102 @@
+#include <random>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include "wake.h"
+
+namespace {
+
+struct Received {
+    int command;
+    int address;
+    std::vector<uint8_t> data;
+
+    bool operator==(const Received &) const = default;
+};
+
+/**
+ * @brief Поток кадров со случайными данными (с FEND/FESC в данных), адресами, порчей, обрывами и мусором
+ */
+std::vector<uint8_t> MakeStream(uint32_t seed, int frames) {
+std::mt19937 rng(seed);
+std::vector<uint8_t> stream;
+    for (int f = 0; f < frames; f++) {
+        const int size = (f % 3 == 0) ? 94 : static_cast<int>(rng() % Wake::PayloadMaximum);
+        QByteArray data;
+        for (int i = 0; i < size; i++) {
+            data.append(static_cast<char>(rng() % 4 == 0 ? 0xC0 + rng() % 0x20 : rng()));
+        }
+
+        const int address = rng() % 4 == 0 ? static_cast<int>(rng() % 128) : Wake::NoAddress;
+        auto tx = Wake::PrepareTx(rng() % 0x70, data, address);
+        if (rng() % 50 == 0) {
+            tx[1 + rng() % (tx.size() - 1)] ^= 1 << (rng() % 8);
+        }
+        if (rng() % 70 == 0) {
+            tx.resize(tx.size() / 2);
+        }
+        stream.insert(stream.end(), tx.begin(), tx.end());
+        if (rng() % 100 == 0) {
+            stream.push_back(0xDB);
+        }
+    }
+    return stream;
+}
+
+std::vector<Received> ByteByByte(const std::vector<uint8_t> &stream, uint32_t &invalid) {
+Wake wake;
+std::vector<Received> frames;
+    for (auto b : stream) {
+        if (wake.ProcessInByte(b) == Wake::READY) {
+            frames.push_back({wake.command(), wake.address(), std::vector<uint8_t>(wake.data().begin(), wake.data().end())});
+        }
+    }
+    invalid = wake.invalidFrames();
+    return frames;
+}
+
+std::vector<Received> Blocks(const std::vector<uint8_t> &stream, uint32_t seed, size_t maxBlock, uint32_t &invalid) {
+std::mt19937 rng(seed);
+Wake wake;
+std::vector<Received> frames;
+size_t pos = 0;
+    while (pos < stream.size()) {
+        const size_t n = std::min<size_t>(1 + rng() % maxBlock, stream.size() - pos);
+        for (const auto &frame : wake.process(stream.data() + pos, stream.data() + pos + n)) {
+            frames.push_back({frame.command, frame.address, std::vector<uint8_t>(frame.data.begin(), frame.data.end())});
+        }
+        pos += n;
+    }
+    invalid = wake.invalidFrames();
+    return frames;
+}
+
+}
+
+TEST(Wake, ProcessMatchesProcessInByte) {
+const auto stream = MakeStream(1, 20000);
+uint32_t invalidByte = 0;
+const auto expected = ByteByByte(stream, invalidByte);
+    ASSERT_GT(expected.size(), 19000u);
+
+    // Блоки от одного байта (разрыв на каждом FESC) до размеров чтения из порта
+    for (size_t maxBlock : {size_t(1), size_t(7), size_t(700), size_t(64 * 1024)}) {
+        uint32_t invalidBlock = 0;
+        EXPECT_EQ(Blocks(stream, 2, maxBlock, invalidBlock), expected) << "block up to " << maxBlock;
+        EXPECT_EQ(invalidBlock, invalidByte) << "block up to " << maxBlock;
+    }
+}
+
+TEST(Wake, EncodeRoundTrip) {
+const std::vector<uint8_t> payload = {0xC0, 0xDB, 0xDC, 0xDD, 0x00, 0xFF};
+    for (int address : {Wake::NoAddress, 0, 0x40, 127}) {
+        const auto tx = Wake::PrepareTx(0x21, QByteArray(reinterpret_cast<const char *>(payload.data()), payload.size()), address);
+        Wake wake;
+        const auto &frames = wake.process(reinterpret_cast<const uint8_t *>(tx.constData()),
+                                          reinterpret_cast<const uint8_t *>(tx.constData()) + tx.size());
+        ASSERT_EQ(frames.size(), 1);
+        EXPECT_EQ(frames[0].command, 0x21);
+        EXPECT_EQ(frames[0].address, address);
+        EXPECT_EQ(std::vector<uint8_t>(frames[0].data.begin(), frames[0].data.end()), payload);
+    }
+}
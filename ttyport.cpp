@@ -0,0 +1,210 @@
+#ifdef __linux__
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "ttyport.h"
+
+
+static bool ToSpeed(int baudRate, speed_t *speed) {
+    switch (baudRate) {
+        case 9600:      *speed = B9600; return true;
+        case 19200:     *speed = B19200; return true;
+        case 38400:     *speed = B38400; return true;
+        case 57600:     *speed = B57600; return true;
+        case 115200:    *speed = B115200; return true;
+        case 230400:    *speed = B230400; return true;
+        case 460800:    *speed = B460800; return true;
+        case 921600:    *speed = B921600; return true;
+        default:        return false;
+    }
+}
+
+TtyPort::TtyPort() {
+    m_eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_eventFd < 0) {
+        SetError("eventfd");
+        return;
+    }
+    m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd < 0) {
+        SetError("epoll_create1");
+        return;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = m_eventFd;
+    if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_eventFd, &ev) != 0) {
+        SetError("epoll_ctl");
+        ::close(m_epollFd);
+        m_epollFd = -1;
+    }
+}
+
+TtyPort::~TtyPort() {
+    close();
+    if (m_epollFd >= 0) {
+        ::close(m_epollFd);
+    }
+    if (m_eventFd >= 0) {
+        ::close(m_eventFd);
+    }
+}
+
+/**
+ * @brief Открыть порт в сыром режиме 8N1 без управления потоком
+ * @param[in] portName - имя порта (ttyUSB0) или полный путь (/dev/pts/3)
+ * @param[in] baudRate - скорость, бод
+ */
+bool TtyPort::open(const QString &portName, int baudRate) {
+    close();
+    if (m_epollFd < 0 || m_eventFd < 0) {
+        return false;       // Ожидание не создано, причина в m_error из конструктора
+    }
+
+    QString path = portName.startsWith('/') ? portName : QString("/dev/%1").arg(portName);
+    speed_t speed;
+    if (!ToSpeed(baudRate, &speed)) {
+        m_error = QString("Unsupported baud rate %1").arg(baudRate);
+        return false;
+    }
+
+    m_fd = ::open(path.toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (m_fd < 0) {
+        return SetError(QString("Cannot open %1").arg(path));
+    }
+
+    termios tio{};
+    if (::tcgetattr(m_fd, &tio) != 0) {
+        SetError("tcgetattr");
+        close();
+        return false;
+    }
+    ::cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    // Чтение неблокирующее и запускается epoll: read() возвращает всё, что уже пришло, не дожидаясь VTIME
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    ::cfsetispeed(&tio, speed);
+    ::cfsetospeed(&tio, speed);
+    if (::tcsetattr(m_fd, TCSANOW, &tio) != 0) {
+        SetError("tcsetattr");
+        close();
+        return false;
+    }
+    ::tcflush(m_fd, TCIOFLUSH);
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = m_fd;
+    if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_fd, &ev) != 0) {
+        SetError("epoll_ctl");
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TtyPort::close() {
+    if (m_fd >= 0) {
+        ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, m_fd, nullptr);
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+/**
+ * @brief Ждать данных в порту или вызова wake()
+ * @param[in] timeoutMs - таймаут, мс; -1 - без таймаута
+ * @return Маска событий Event, 0 по таймауту
+ */
+int TtyPort::wait(int timeoutMs) {
+epoll_event events[2];
+    int n = ::epoll_wait(m_epollFd, events, 2, timeoutMs);
+    if (n < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+        SetError("epoll_wait");
+        return Error;
+    }
+
+    int ret = 0;
+    for (int i = 0; i < n; i++) {
+        if (events[i].data.fd == m_eventFd) {
+            uint64_t counter;
+            ::read(m_eventFd, &counter, sizeof(counter));
+            ret |= Woken;
+        } else {
+            if (events[i].events & EPOLLIN) {
+                ret |= Readable;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                m_error = "Device disconnected";
+                ret |= Error;
+            }
+        }
+    }
+    return ret;
+}
+
+/**
+ * @brief Разбудить wait(). Можно вызывать из любого потока
+ */
+void TtyPort::wake() {
+const uint64_t one = 1;
+    ::write(m_eventFd, &one, sizeof(one));
+}
+
+qint64 TtyPort::read(uint8_t *data, size_t size) {
+    ssize_t n = ::read(m_fd, data, size);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EINTR) {
+            return 0;
+        }
+        SetError("read");
+    }
+    return n;
+}
+
+qint64 TtyPort::write(const QByteArray &data) {
+qint64 written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(m_fd, data.constData() + written, data.size() - written);
+        if (n > 0) {
+            written += n;
+        } else if (n < 0 && errno == EAGAIN) {
+            pollfd pfd{m_fd, POLLOUT, 0};
+            if (::poll(&pfd, 1, 100) <= 0) {
+                break;
+            }
+        } else if (n < 0 && errno != EINTR) {
+            SetError("write");
+            return -1;
+        }
+    }
+    return written;
+}
+
+qint64 TtyPort::bytesAvailable() const {
+int n = 0;
+    if (m_fd < 0 || ::ioctl(m_fd, FIONREAD, &n) != 0) {
+        return 0;
+    }
+    return n;
+}
+
+bool TtyPort::SetError(const QString &what) {
+    m_error = QString("%1: %2").arg(what).arg(::strerror(errno));
+    return false;
+}
+
+#endif // __linux__
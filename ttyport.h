@@ -0,0 +1,53 @@
+#ifndef TTYPORT_H
+#define TTYPORT_H
+
+#ifdef __linux__
+
+#include <cstdint>
+#include <QByteArray>
+#include <QString>
+
+/**
+ * @brief Последовательный порт Linux на termios с ожиданием через epoll
+ *
+ * Ожидание wait() просыпается по данным в порту или по wake() из другого потока (eventfd), поэтому
+ * опрос с таймаутом не нужен. Работает и с реальным tty, и с ведомой стороной псевдотерминала.
+ */
+class TtyPort {
+public:
+    enum Event {
+        Readable = 0x01,    ///< В порту есть данные
+        Woken = 0x02,       ///< Вызван wake()
+        Error = 0x04        ///< Ошибка или отключение устройства
+    };
+
+    TtyPort();
+    ~TtyPort();
+    TtyPort(const TtyPort &) = delete;
+    TtyPort &operator=(const TtyPort &) = delete;
+
+    bool open(const QString &portName, int baudRate);
+    void close();
+    bool isOpen() const { return m_fd >= 0; }
+
+    int wait(int timeoutMs);
+    void wake();
+
+    qint64 read(uint8_t *data, size_t size);
+    qint64 write(const QByteArray &data);
+    qint64 bytesAvailable() const;
+
+    QString errorString() const { return m_error; }
+
+private:
+    int m_fd = -1;
+    int m_eventFd = -1;
+    int m_epollFd = -1;
+    QString m_error;
+
+    bool SetError(const QString &what);
+};
+
+#endif // __linux__
+
+#endif // TTYPORT_H
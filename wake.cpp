@@ -1,13 +1,8 @@
+#include <algorithm>
+#include <cstring>
 #include "wake.h"
-
-/// Frame End
-#define WAKE_CODE_FEND          (0xC0)
-/// Frame Escape
-#define WAKE_CODE_FESC          (0xDB)
-/// Transposed Frame End
-#define WAKE_CODE_TFEND         (0xDC)
-/// Transposed Frame Escape
-#define WAKE_CODE_TFESC         (0xDD)
+#include "crc8.h"
+#include "wakescan.h"
 
 #define CRC_INIT                (0x00) 			// Innitial CRC value
 
@@ -15,11 +10,9 @@
 
 
 
-static void Do_Crc8(uint8_t b, uint8_t *crc);
-
-
 Wake::Wake(QObject *parent) : QObject(parent) {
     logger = spdlog::get("Wake");
+    logger->debug("Delimiter scanner: {}", wakescan::implementation());
 }
 
 Wake::~Wake() {
@@ -35,18 +28,23 @@ QByteArray arr(reinterpret_cast<const char *>(m_receivedData.constData()), m_rec
     return arr;
 }
 
-Wake::Status Wake::ProcessInByte(uint8_t data) {
-Wake::Status ret = Wake::Status::INIT;
+/**
+ * @brief Общий для обоих приёмников автомат: FEND, байт-стаффинг, заголовок и CRC кадра
+ * @param[in,out] data - принятый байт, после разбора - байт без стаффинга
+ * @return Что сделать приёмнику с байтом. Данные кадра приёмники хранят каждый по-своему
+ */
+Wake::RxEvent Wake::RxDecode(uint8_t &data) {
     if (data == WAKE_CODE_FEND) {
         Rx_Pre = data;
         Rx_Crc = CRC_INIT;
         Rx_FSM = WAIT_ADDR_OR_CMD;
-        Do_Crc8(data, &Rx_Crc);
-        return Wake::Status::INIT;
+        Rx_Crc = crc8::update(Rx_Crc, data);
+        m_receivedAddress = NoAddress;
+        return RX_START;
     }
 
     if (Rx_FSM == WAIT_FEND)
-        return Wake::Status::INIT;
+        return RX_NONE;
     
     uint8_t Pre = Rx_Pre;
     Rx_Pre = data;
@@ -57,12 +55,11 @@ Wake::Status ret = Wake::Status::INIT;
             data = WAKE_CODE_FEND;
         else {
             Rx_FSM = WAIT_FEND;
-            // CMD
-            return Wake::Status::INIT;
+            return RX_NONE;
         }
     } else {
         if (data == WAKE_CODE_FESC)
-            return Wake::Status::INIT;
+            return RX_NONE;
     }
 
     switch (Rx_FSM) {
@@ -70,111 +67,217 @@ Wake::Status ret = Wake::Status::INIT;
             if (data & 0x80) {	// Адрес
                 // Принят адрес, старший бит - 1, все адреса принимаем
                 data = data & 0x7F;
-                Do_Crc8(data, &Rx_Crc);
+                m_receivedAddress = data;
+                Rx_Crc = crc8::update(Rx_Crc, data);
                 Rx_FSM = WAIT_CMD;
-                break;
             } else {
                 // Принята команда, старший бит - 0
                 m_receivedCommand = data;
-                Do_Crc8(data, &Rx_Crc);
+                Rx_Crc = crc8::update(Rx_Crc, data);
                 Rx_FSM = WAIT_NBT;
             }
-            break;
+            return RX_NONE;
         }
 
         case WAIT_CMD: {
             if (data & 0x80) {
                 // CMD not valid. Upper bit is High
                 Rx_FSM = WAIT_FEND;
-                break;
+                return RX_NONE;
             }
 
             m_receivedCommand = data;
-            Do_Crc8(data, &Rx_Crc);
+            Rx_Crc = crc8::update(Rx_Crc, data);
             Rx_FSM = WAIT_NBT;
-            break;
+            return RX_NONE;
         }
 
         case WAIT_NBT: {
             if (data > FRAME_SIZE_MAXIMUM) {
                 Rx_FSM = WAIT_FEND;
-                break;
+                return RX_NONE;
             }
 
-            m_receivedData.clear();
-            m_receivedData.reserve(data);
-            m_receivedData.fill(0, data);
-            Do_Crc8(data, &Rx_Crc);
+            m_rxNbt = data;
+            Rx_Crc = crc8::update(Rx_Crc, data);
             Rx_Ptr = 0;
             Rx_FSM = WAIT_DATA;
-            break;
+            return RX_HEADER;
         }
 
         case WAIT_DATA: {
-            if (Rx_Ptr < m_receivedData.size()) {
-                m_receivedData[Rx_Ptr++] = data;
-                Do_Crc8(data, &Rx_Crc);
-                break;
+            if (Rx_Ptr < m_rxNbt) {
+                Rx_Ptr++;
+                Rx_Crc = crc8::update(Rx_Crc, data);
+                return RX_DATA;
             }
+
+            Rx_FSM = WAIT_FEND;
             if (data != Rx_Crc) {
-                Rx_FSM = WAIT_FEND;
-                emit recvInvalid(m_receivedData, m_receivedCommand);
-                break;
+                m_invalidFrames++;
+                return RX_INVALID;
             }
-            Rx_FSM = WAIT_FEND;
-            ret = Wake::READY;
+            return RX_VALID;
+        }
+    }
+
+    return RX_NONE;
+}
+
+Wake::Status Wake::ProcessInByte(uint8_t data) {
+    switch (RxDecode(data)) {
+        case RX_HEADER:
+            m_receivedData.clear();
+            m_receivedData.fill(0, m_rxNbt);
+            break;
+
+        case RX_DATA:
+            m_receivedData[Rx_Ptr - 1] = data;
+            break;
+
+        case RX_INVALID:
+            emit recvInvalid(m_receivedData, m_receivedCommand);
+            break;
+
+        case RX_VALID:
             emit recvValid(m_receivedData, m_receivedCommand);
+            return Wake::READY;
+
+        default:
             break;
-        }
     }
 
-    return ret;
+    return Wake::Status::INIT;
 }
 
-QByteArray Wake::PrepareTx(uint8_t command, const QByteArray &data) {
-QByteArray out;
-uint8_t crc = CRC_INIT;
+/**
+ * @brief Блочный разбор принятого потока
+ * @param[in] begin - начало принятого блока
+ * @param[in] end - конец принятого блока
+ * @return Все полные кадры с верной CRC, найденные в блоке. Незавершённый кадр сохраняется до следующего вызова
+ * 
+ * Разбирает те же кадры, что и ProcessInByte(), но без сигналов на каждый кадр. Не смешивать с ProcessInByte()
+ * на одном объекте: состояние автомата у них общее.
+ */
+const QList<Wake::Frame> &Wake::process(const uint8_t *begin, const uint8_t *end) {
+    m_frames.clear();
 
-    Do_Crc8(WAKE_CODE_FEND, &crc);
-    out.append(WAKE_CODE_FEND);
+    // Переносим незавершённый кадр в начало буфера, кадры прошлого вызова больше не нужны
+    const size_t partial = (Rx_FSM == WAIT_DATA) ? m_rxEnd - m_rxStart : 0;
+    if (partial > 0 && m_rxStart > 0) {
+        ::memmove(m_rxStorage.data(), m_rxStorage.data() + m_rxStart, partial);
+    }
+    m_rxStart = 0;
+    m_rxEnd = partial;
 
-    Do_Crc8(command, &crc);
-    out = StuffTx(out, command);
+    // Каждый принятый байт даёт не больше одного байта данных, перераспределений во время разбора не будет
+    const size_t required = partial + static_cast<size_t>(end - begin);
+    if (m_rxStorage.size() < required) {
+        m_rxStorage.resize(required);
+    }
 
-    auto nbt = data.size();
-    Do_Crc8(nbt, &crc);
-    out = StuffTx(out, nbt);
+const uint8_t *p = begin;
+    while (p < end) {
+        if (Rx_FSM == WAIT_DATA && Rx_Pre != WAKE_CODE_FESC) {
+            // Отрезок данных без FEND/FESC копируем целиком
+            const size_t need = m_rxNbt - Rx_Ptr;
+            const uint8_t *stop = p + std::min<size_t>(need, end - p);
+            const uint8_t *run = wakescan::find(p, stop);
 
-    for (int i = 0; i < nbt; i++) {
-        Do_Crc8(data[i], &crc);
-        out = StuffTx(out, data[i]);
+            const size_t len = run - p;
+            if (len > 0) {
+                ::memcpy(m_rxStorage.data() + m_rxEnd, p, len);
+                Rx_Crc = crc8::compute(Rx_Crc, p, len);
+                m_rxEnd += len;
+                Rx_Ptr += static_cast<uint8_t>(len);
+                Rx_Pre = run[-1];
+                p = run;
+                continue;
+            }
+        }
+        RxByte(*p++);
     }
 
-    out = StuffTx(out, crc);
-    return out;
+    return m_frames;
 }
 
-QByteArray &Wake::StuffTx(QByteArray &buf, uint8_t tx) {
-    if (tx == WAKE_CODE_FEND) {
-        buf.append(WAKE_CODE_FESC);
-        buf.append(WAKE_CODE_TFEND);
-        return buf;
-    } else if (tx == WAKE_CODE_FESC) {
-        buf.append(WAKE_CODE_FESC);
-        buf.append(WAKE_CODE_TFESC);
-        return buf;
+/**
+ * @brief Медленный путь блочного приёмника: байты заголовка, стаффинга и CRC, данные кладутся в m_rxStorage
+ */
+void Wake::RxByte(uint8_t data) {
+    switch (RxDecode(data)) {
+        case RX_START:
+        case RX_HEADER:
+        case RX_INVALID:
+            m_rxEnd = m_rxStart;
+            break;
+
+        case RX_DATA:
+            m_rxStorage[m_rxEnd++] = data;
+            break;
+
+        case RX_VALID:
+            m_frames.append(Frame{m_receivedCommand, std::span<const uint8_t>(m_rxStorage.data() + m_rxStart, m_rxNbt), m_receivedAddress});
+            m_rxStart = m_rxEnd;
+            break;
+
+        default:
+            break;
     }
-    buf.append(tx);
-    return buf;
 }
 
+QByteArray Wake::PrepareTx(uint8_t command, const QByteArray &data, int address) {
+QByteArray out(TxSizeMaximum(data.size()), Qt::Uninitialized);
+    auto size = Encode(std::span<uint8_t>(reinterpret_cast<uint8_t *>(out.data()), out.size()), command,
+                       std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(data.constData()), data.size()), address);
+    out.resize(size);
+    return out;
+}
+
+/**
+ * @brief Собрать кадр Wake за один проход
+ * @param[out] out - буфер не меньше TxSizeMaximum(data.size())
+ * @param[in] command - команда
+ * @param[in] data - данные команды, не больше PayloadMaximum
+ * @param[in] address - адрес получателя 0..127, NoAddress - кадр без адреса
+ * @return размер кадра, 0 - данные не помещаются в кадр или в буфер
+ */
+size_t Wake::Encode(std::span<uint8_t> out, uint8_t command, std::span<const uint8_t> data, int address) {
+    if (data.size() > PayloadMaximum || out.size() < TxSizeMaximum(data.size())) {
+        return 0;
+    }
 
-static void Do_Crc8(uint8_t b, uint8_t *crc) {
-	for (uint8_t i = 0; i < 8; b = b >> 1, i++) {
-        if ((b ^ *crc) & 1) {
-            *crc = ((*crc ^ 0x18) >> 1) | 0x80;
+uint8_t *p = out.data();
+uint8_t crc = crc8::update(CRC_INIT, WAKE_CODE_FEND);
+    auto stuff = [&p](uint8_t tx) {
+        if (tx == WAKE_CODE_FEND) {
+            *p++ = WAKE_CODE_FESC;
+            *p++ = WAKE_CODE_TFEND;
+        } else if (tx == WAKE_CODE_FESC) {
+            *p++ = WAKE_CODE_FESC;
+            *p++ = WAKE_CODE_TFESC;
         } else {
-            *crc = (*crc >> 1) & ~0x80;
+            *p++ = tx;
         }
+    };
+
+    *p++ = WAKE_CODE_FEND;
+    if (address >= 0) {
+        // В CRC адрес входит без признака адреса в старшем бите
+        crc = crc8::update(crc, address & 0x7F);
+        stuff(static_cast<uint8_t>(address | 0x80));
+    }
+
+    crc = crc8::update(crc, command);
+    stuff(command);
+    crc = crc8::update(crc, static_cast<uint8_t>(data.size()));
+    stuff(static_cast<uint8_t>(data.size()));
+
+    crc = crc8::compute(crc, data.data(), data.size());
+    for (auto b : data) {
+        stuff(b);
     }
+
+    stuff(crc);
+    return p - out.data();
 }
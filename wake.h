@@ -2,7 +2,12 @@
 #define WAKE_H
 
 #include <QObject>
+#include <QList>
+#include <array>
+#include <span>
+#include <vector>
 #include <spdlog/spdlog.h>
+#include "ringbuffer.h"
 
 class Wake : public QObject {
     Q_OBJECT
@@ -17,11 +22,75 @@ public:
         READY
     };
 
+    static constexpr int NoAddress = -1;              ///< Кадр без адреса (связь точка-точка)
+
+    /// Принятый кадр Wake. Данные указывают во внутренний буфер и действительны до следующего вызова process()
+    struct Frame {
+        uint8_t command;
+        std::span<const uint8_t> data;
+        int address = NoAddress;                        ///< Адрес отправителя, 0..127
+    };
+
     Status ProcessInByte(uint8_t data);
+    const QList<Frame> &process(const uint8_t *begin, const uint8_t *end);
+
+    /**
+     * @brief Разобрать всё накопленное в кольцевом буфере порциями не больше slice байт
+     * @param[in] onFrame - вызывается для каждого кадра порции
+     * @param[in] onSlice - вызывается после каждой порции, например для обслуживания передачи
+     * @return Разобрано кадров
+     */
+    template <typename OnFrame, typename OnSlice>
+    size_t processRing(ByteRingBuffer &ring, size_t slice, OnFrame &&onFrame, OnSlice &&onSlice) {
+        size_t count = 0;
+        while (!ring.isEmpty()) {
+            auto span = ring.readSpan();
+            span = span.first(std::min(span.size(), slice));
+            const auto &frames = process(span.data(), span.data() + span.size());
+            for (const auto &frame : frames) {
+                onFrame(frame);
+            }
+            count += frames.size();
+            ring.consume(span.size());
+            onSlice();
+        }
+        return count;
+    }
+    uint32_t invalidFrames() const { return m_invalidFrames; }
     uint8_t command() const { return m_receivedCommand; }
+    int address() const { return m_receivedAddress; }
     const QList<uint8_t> &data() const { return m_receivedData; }
     const QByteArray dataArray() const;
-    static QByteArray PrepareTx(uint8_t command, const QByteArray &data);
+    static QByteArray PrepareTx(uint8_t command, const QByteArray &data, int address = NoAddress);
+
+    static constexpr size_t PayloadMaximum = 128;      ///< Наибольшее NBT, которое примет приёмник
+
+    /// Наибольший размер кадра: FEND и вдвое (байт-стаффинг) адрес, команда, NBT, данные и CRC
+    static constexpr size_t TxSizeMaximum(size_t payload) { return 1 + 2 * (4 + payload); }
+
+    /**
+     * @brief Кадр для передачи в буфере фиксированного размера, без динамической памяти
+     * @tparam Payload - размер данных команды
+     */
+    template <size_t Payload>
+    struct TxFrame {
+        std::array<uint8_t, Payload> payload;               ///< Данные команды до стаффинга
+        std::array<uint8_t, TxSizeMaximum(Payload)> buffer;
+        size_t size = 0;
+
+        std::span<const uint8_t> bytes() const { return std::span<const uint8_t>(buffer.data(), size); }
+    };
+
+    static size_t Encode(std::span<uint8_t> out, uint8_t command, std::span<const uint8_t> data, int address = NoAddress);
+
+    /// Кадр с данными фиксированного размера на стеке. Типизированные данные собирает tecdesc::Descriptor
+    template <size_t Payload>
+    static TxFrame<Payload> Encode(uint8_t command, const std::array<uint8_t, Payload> &payload, int address = NoAddress) {
+        TxFrame<Payload> frame;
+        frame.payload = payload;
+        frame.size = Encode(frame.buffer, command, frame.payload, address);
+        return frame;
+    }
 
 signals:
     void recvValid(const QList<uint8_t> &data, uint8_t command);
@@ -32,6 +101,7 @@ private:
     
     QList<uint8_t> m_receivedData;
     uint8_t m_receivedCommand;
+    int m_receivedAddress = NoAddress;      ///< Адрес принимаемого кадра, NoAddress - кадр без адреса
 
 	enum FsmRxState {
 		WAIT_FEND,          /// ожидание приема FEND
@@ -43,14 +113,32 @@ private:
 		WAIT_CARR 	        /// ожидание несущей
 	};
 
-    uint8_t m_iAddressLocal = 0;
-    uint8_t m_iAddressRemote = 0;
     uint8_t Rx_FSM = WAIT_FEND;
     uint8_t Rx_Pre;	// Предыдущий принятый байт
     uint8_t Rx_Crc;
-    uint8_t Rx_Ptr = 0;
+    uint8_t Rx_Ptr = 0;                     ///< Принято байт данных кадра
+    uint8_t m_rxNbt = 0;                    ///< Размер данных принимаемого кадра
+
+    // Состояние блочного приёмника process(). Незавершённый кадр хранится в m_rxStorage
+    // начиная с m_rxStart и переносится в начало буфера при следующем вызове
+    std::vector<uint8_t> m_rxStorage;
+    size_t m_rxStart = 0;
+    size_t m_rxEnd = 0;
+    QList<Frame> m_frames;
+    uint32_t m_invalidFrames = 0;
+
+    /// Событие автомата приёма для байта
+    enum RxEvent {
+        RX_NONE,            ///< Байт заголовка или стаффинга, либо ошибка кадра
+        RX_START,           ///< FEND, начат новый кадр
+        RX_HEADER,          ///< Принят NBT, дальше данные
+        RX_DATA,            ///< Байт данных Rx_Ptr - 1
+        RX_VALID,           ///< Кадр принят, CRC верна
+        RX_INVALID          ///< Кадр принят, CRC неверна
+    };
 
-    static QByteArray &StuffTx(QByteArray &buf, uint8_t tx);
+    RxEvent RxDecode(uint8_t &data);
+    void RxByte(uint8_t data);
 };
 
 
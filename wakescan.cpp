@@ -0,0 +1,124 @@
+#include <bit>
+#include "wakescan.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define WAKESCAN_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define WAKESCAN_TARGET_SSE2
+#define WAKESCAN_TARGET_AVX2
+#else
+// 32-битная сборка может идти без -msse2: SSE2 тоже включается только для своей функции
+#define WAKESCAN_TARGET_SSE2 __attribute__((target("sse2")))
+#define WAKESCAN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace wakescan {
+
+using FindFunc = const uint8_t *(*)(const uint8_t *, const uint8_t *);
+
+const uint8_t *findScalar(const uint8_t *begin, const uint8_t *end) {
+    for (; begin < end; ++begin) {
+        if (*begin == WAKE_CODE_FEND || *begin == WAKE_CODE_FESC) {
+            break;
+        }
+    }
+    return begin;
+}
+
+#ifdef WAKESCAN_X86
+WAKESCAN_TARGET_SSE2 static const uint8_t *findSse2(const uint8_t *begin, const uint8_t *end) {
+const __m128i fend = _mm_set1_epi8(static_cast<char>(WAKE_CODE_FEND));
+const __m128i fesc = _mm_set1_epi8(static_cast<char>(WAKE_CODE_FESC));
+    for (; end - begin >= 16; begin += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+        const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, fend), _mm_cmpeq_epi8(v, fesc))));
+        if (mask != 0) {
+            return begin + std::countr_zero(mask);
+        }
+    }
+    return findScalar(begin, end);
+}
+
+WAKESCAN_TARGET_AVX2 static const uint8_t *findAvx2(const uint8_t *begin, const uint8_t *end) {
+const __m256i fend = _mm256_set1_epi8(static_cast<char>(WAKE_CODE_FEND));
+const __m256i fesc = _mm256_set1_epi8(static_cast<char>(WAKE_CODE_FESC));
+    for (; end - begin >= 32; begin += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+        const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, fend), _mm256_cmpeq_epi8(v, fesc))));
+        if (mask != 0) {
+            return begin + std::countr_zero(mask);
+        }
+    }
+    return findSse2(begin, end);
+}
+
+static bool HasAvx2() {
+#ifdef _MSC_VER
+int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) {
+        return false;
+    }
+    __cpuid(regs, 1);
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    if (!osxsave || (_xgetbv(0) & 0x06) != 0x06) {
+        return false;
+    }
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static bool HasSse2() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(_MSC_VER)
+    return true;        // x86-64 - всегда, MSVC для x86 по умолчанию собирает с /arch:SSE2
+#else
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+#endif
+
+struct Implementation {
+    FindFunc func;
+    const char *name;
+};
+
+static Implementation Select() {
+#ifdef WAKESCAN_X86
+    if (HasAvx2()) {
+        return {findAvx2, "AVX2"};
+    }
+    if (HasSse2()) {
+        return {findSse2, "SSE2"};
+    }
+    return {findScalar, "Scalar"};
+#else
+    return {findScalar, "Scalar"};
+#endif
+}
+
+static const Implementation &Selected() {
+static const Implementation impl = Select();
+    return impl;
+}
+
+/**
+ * @brief Найти первый FEND или FESC
+ * @param[in] begin - начало блока
+ * @param[in] end - конец блока
+ * @return Указатель на первый разделитель или end, если разделителей нет
+ */
+const uint8_t *find(const uint8_t *begin, const uint8_t *end) {
+    return Selected().func(begin, end);
+}
+
+const char *implementation() {
+    return Selected().name;
+}
+
+} // namespace wakescan
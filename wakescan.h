@@ -0,0 +1,28 @@
+#ifndef WAKESCAN_H
+#define WAKESCAN_H
+
+#include <cstdint>
+
+/// Frame End
+#define WAKE_CODE_FEND          (0xC0)
+/// Frame Escape
+#define WAKE_CODE_FESC          (0xDB)
+/// Transposed Frame End
+#define WAKE_CODE_TFEND         (0xDC)
+/// Transposed Frame Escape
+#define WAKE_CODE_TFESC         (0xDD)
+
+/**
+ * @brief Поиск разделителей Wake (FEND 0xC0 и FESC 0xDB) в принятом потоке
+ *
+ * Реализация (AVX2, SSE2 или скалярная) выбирается один раз при первом вызове по возможностям процессора.
+ */
+namespace wakescan {
+
+const uint8_t *find(const uint8_t *begin, const uint8_t *end);
+const uint8_t *findScalar(const uint8_t *begin, const uint8_t *end);
+const char *implementation();
+
+} // namespace wakescan
+
+#endif // WAKESCAN_H